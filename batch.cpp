@@ -0,0 +1,361 @@
+/*******************************************************************************
+* Deep Winkelman
+*
+* Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
+* 9 June 2017
+*
+* Implementation for batched attack sets with Kogge-Stone fills.
+*/
+
+#include "batch.h"
+#include "util.h"
+
+// Files that a one-square step to the side would wrap around onto
+static const Bitmask_t NOT_A_FILE = 0xfefefefefefefefe;
+static const Bitmask_t NOT_H_FILE = 0x7f7f7f7f7f7f7f7f;
+static const Bitmask_t NOT_AB_FILES = 0xfcfcfcfcfcfcfcfc;
+static const Bitmask_t NOT_GH_FILES = 0x3f3f3f3f3f3f3f3f;
+static const Bitmask_t ALL_SQUARES = 0xffffffffffffffff;
+
+// Check the processor and operating system for AVX2 support
+static bool cpu_has_avx2() {
+#if defined(_MSC_VER) && defined(_M_X64)
+	int info[4];
+	__cpuid(info, 1);
+	// AVX, and the operating system saving the AVX registers
+	if (!((info[2] >> 27) & 1) || !((info[2] >> 28) & 1)) return false;
+	if ((_xgetbv(0) & 6) != 6) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] >> 5) & 1;
+#elif defined(__GNUC__) && defined(__x86_64__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#else
+	return false;
+#endif
+}
+
+/**
+ * One lane at a time
+ */
+
+// Shift towards the higher squares for positive shifts
+template<int Shift>
+static inline Bitmask_t shift(const Bitmask_t b) {
+	return (Shift > 0) ? b << (Shift & 63) : b >> (-Shift & 63);
+}
+
+// Squares attacked in one direction by sliders moving through empty squares.
+// Wrap removes the file that a step in this direction would wrap around onto.
+template<int Shift>
+static inline Bitmask_t fill(Bitmask_t sliders, Bitmask_t empty, const Bitmask_t wrap) {
+	empty &= wrap;
+	sliders |= empty & shift<Shift>(sliders);
+	empty &= shift<Shift>(empty);
+	sliders |= empty & shift<2 * Shift>(sliders);
+	empty &= shift<2 * Shift>(empty);
+	sliders |= empty & shift<4 * Shift>(sliders);
+	return shift<Shift>(sliders) & wrap;
+}
+
+static inline Bitmask_t rook_fill(const Bitmask_t rooks, const Bitmask_t empty) {
+	return fill<8>(rooks, empty, ALL_SQUARES) | fill<-8>(rooks, empty, ALL_SQUARES)
+		| fill<1>(rooks, empty, NOT_A_FILE) | fill<-1>(rooks, empty, NOT_H_FILE);
+}
+
+static inline Bitmask_t bishop_fill(const Bitmask_t bishops, const Bitmask_t empty) {
+	return fill<9>(bishops, empty, NOT_A_FILE) | fill<7>(bishops, empty, NOT_H_FILE)
+		| fill<-7>(bishops, empty, NOT_A_FILE) | fill<-9>(bishops, empty, NOT_H_FILE);
+}
+
+static inline Bitmask_t knight_fill(const Bitmask_t knights) {
+	const Bitmask_t one_file = ((knights << 1) & NOT_A_FILE) | ((knights >> 1) & NOT_H_FILE);
+	const Bitmask_t two_files = ((knights << 2) & NOT_AB_FILES) | ((knights >> 2) & NOT_GH_FILES);
+	return (one_file << 16) | (one_file >> 16) | (two_files << 8) | (two_files >> 8);
+}
+
+static inline Bitmask_t king_fill(const Bitmask_t king) {
+	const Bitmask_t row = king | ((king << 1) & NOT_A_FILE) | ((king >> 1) & NOT_H_FILE);
+	return (row | (row << 8) | (row >> 8)) & ~king;
+}
+
+static inline Bitmask_t pawn_fill(const Bitmask_t pawns, const bool white) {
+	if (white) return ((pawns << 7) & NOT_H_FILE) | ((pawns << 9) & NOT_A_FILE);
+	else return ((pawns >> 9) & NOT_H_FILE) | ((pawns >> 7) & NOT_A_FILE);
+}
+
+/**
+ * Four lanes at a time with AVX2.
+ * The same fills as above, one instruction for each operation.
+ */
+
+#if AVX2_AVAILABLE
+
+// GCC only emits AVX2 for functions that ask for it
+#if defined(__GNUC__) && !defined(__AVX2__)
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define AVX2_FUNCTION
+#endif
+
+template<int Shift>
+AVX2_FUNCTION static inline __m256i shift_avx2(const __m256i b) {
+	return (Shift > 0) ? _mm256_slli_epi64(b, Shift & 63) : _mm256_srli_epi64(b, -Shift & 63);
+}
+
+template<int Shift>
+AVX2_FUNCTION static inline __m256i fill_avx2(__m256i sliders, __m256i empty, const __m256i wrap) {
+	empty = _mm256_and_si256(empty, wrap);
+	sliders = _mm256_or_si256(sliders, _mm256_and_si256(empty, shift_avx2<Shift>(sliders)));
+	empty = _mm256_and_si256(empty, shift_avx2<Shift>(empty));
+	sliders = _mm256_or_si256(sliders, _mm256_and_si256(empty, shift_avx2<2 * Shift>(sliders)));
+	empty = _mm256_and_si256(empty, shift_avx2<2 * Shift>(empty));
+	sliders = _mm256_or_si256(sliders, _mm256_and_si256(empty, shift_avx2<4 * Shift>(sliders)));
+	return _mm256_and_si256(shift_avx2<Shift>(sliders), wrap);
+}
+
+AVX2_FUNCTION static inline __m256i rook_fill_avx2(const __m256i rooks, const __m256i empty) {
+	const __m256i all = _mm256_set1_epi64x(ALL_SQUARES);
+	const __m256i not_a = _mm256_set1_epi64x(NOT_A_FILE), not_h = _mm256_set1_epi64x(NOT_H_FILE);
+	return _mm256_or_si256(
+		_mm256_or_si256(fill_avx2<8>(rooks, empty, all), fill_avx2<-8>(rooks, empty, all)),
+		_mm256_or_si256(fill_avx2<1>(rooks, empty, not_a), fill_avx2<-1>(rooks, empty, not_h)));
+}
+
+AVX2_FUNCTION static inline __m256i bishop_fill_avx2(const __m256i bishops, const __m256i empty) {
+	const __m256i not_a = _mm256_set1_epi64x(NOT_A_FILE), not_h = _mm256_set1_epi64x(NOT_H_FILE);
+	return _mm256_or_si256(
+		_mm256_or_si256(fill_avx2<9>(bishops, empty, not_a), fill_avx2<7>(bishops, empty, not_h)),
+		_mm256_or_si256(fill_avx2<-7>(bishops, empty, not_a), fill_avx2<-9>(bishops, empty, not_h)));
+}
+
+AVX2_FUNCTION static inline __m256i knight_fill_avx2(const __m256i knights) {
+	const __m256i one_file = _mm256_or_si256(
+		_mm256_and_si256(_mm256_slli_epi64(knights, 1), _mm256_set1_epi64x(NOT_A_FILE)),
+		_mm256_and_si256(_mm256_srli_epi64(knights, 1), _mm256_set1_epi64x(NOT_H_FILE)));
+	const __m256i two_files = _mm256_or_si256(
+		_mm256_and_si256(_mm256_slli_epi64(knights, 2), _mm256_set1_epi64x(NOT_AB_FILES)),
+		_mm256_and_si256(_mm256_srli_epi64(knights, 2), _mm256_set1_epi64x(NOT_GH_FILES)));
+	return _mm256_or_si256(
+		_mm256_or_si256(_mm256_slli_epi64(one_file, 16), _mm256_srli_epi64(one_file, 16)),
+		_mm256_or_si256(_mm256_slli_epi64(two_files, 8), _mm256_srli_epi64(two_files, 8)));
+}
+
+AVX2_FUNCTION static inline __m256i king_fill_avx2(const __m256i king) {
+	const __m256i row = _mm256_or_si256(king, _mm256_or_si256(
+		_mm256_and_si256(_mm256_slli_epi64(king, 1), _mm256_set1_epi64x(NOT_A_FILE)),
+		_mm256_and_si256(_mm256_srli_epi64(king, 1), _mm256_set1_epi64x(NOT_H_FILE))));
+	const __m256i area = _mm256_or_si256(row,
+		_mm256_or_si256(_mm256_slli_epi64(row, 8), _mm256_srli_epi64(row, 8)));
+	return _mm256_andnot_si256(king, area);
+}
+
+AVX2_FUNCTION static inline __m256i pawn_fill_avx2(const __m256i pawns, const bool white) {
+	const __m256i not_a = _mm256_set1_epi64x(NOT_A_FILE), not_h = _mm256_set1_epi64x(NOT_H_FILE);
+	if (white) return _mm256_or_si256(
+		_mm256_and_si256(_mm256_slli_epi64(pawns, 7), not_h),
+		_mm256_and_si256(_mm256_slli_epi64(pawns, 9), not_a));
+	else return _mm256_or_si256(
+		_mm256_and_si256(_mm256_srli_epi64(pawns, 9), not_h),
+		_mm256_and_si256(_mm256_srli_epi64(pawns, 7), not_a));
+}
+
+AVX2_FUNCTION static inline __m256i load(const Bitmask_t lanes[BATCH_SIZE]) {
+	return _mm256_loadu_si256((const __m256i *)lanes);
+}
+
+AVX2_FUNCTION static void rook_attacks_avx2(const Bitmask_t rooks[BATCH_SIZE],
+	const Bitmask_t empty[BATCH_SIZE], Bitmask_t output[BATCH_SIZE]) {
+	_mm256_storeu_si256((__m256i *)output, rook_fill_avx2(load(rooks), load(empty)));
+}
+
+AVX2_FUNCTION static void bishop_attacks_avx2(const Bitmask_t bishops[BATCH_SIZE],
+	const Bitmask_t empty[BATCH_SIZE], Bitmask_t output[BATCH_SIZE]) {
+	_mm256_storeu_si256((__m256i *)output, bishop_fill_avx2(load(bishops), load(empty)));
+}
+
+#endif
+
+/**
+ * Pieces of one side in each lane
+ */
+
+struct SideLanes {
+	Bitmask_t pawns[BATCH_SIZE], knights[BATCH_SIZE], orthogonal[BATCH_SIZE],
+		diagonal[BATCH_SIZE], king[BATCH_SIZE], empty[BATCH_SIZE];
+};
+
+static void side_attacks(const SideLanes & lanes, const bool white, Bitmask_t output[BATCH_SIZE]) {
+	for (int i = 0; i < BATCH_SIZE; i++) {
+		output[i] = pawn_fill(lanes.pawns[i], white) | knight_fill(lanes.knights[i])
+			| king_fill(lanes.king[i])
+			| rook_fill(lanes.orthogonal[i], lanes.empty[i])
+			| bishop_fill(lanes.diagonal[i], lanes.empty[i]);
+	}
+}
+
+#if AVX2_AVAILABLE
+AVX2_FUNCTION static void side_attacks_avx2(const SideLanes & lanes, const bool white,
+	Bitmask_t output[BATCH_SIZE]) {
+	const __m256i empty = load(lanes.empty);
+	__m256i attacks = _mm256_or_si256(
+		pawn_fill_avx2(load(lanes.pawns), white), knight_fill_avx2(load(lanes.knights)));
+	attacks = _mm256_or_si256(attacks, king_fill_avx2(load(lanes.king)));
+	attacks = _mm256_or_si256(attacks, rook_fill_avx2(load(lanes.orthogonal), empty));
+	attacks = _mm256_or_si256(attacks, bishop_fill_avx2(load(lanes.diagonal), empty));
+	_mm256_storeu_si256((__m256i *)output, attacks);
+}
+#endif
+
+/**
+ * Public interface
+ */
+
+AttackBatch::AttackBatch(const bool allow_avx2) {
+	use_avx2 = AVX2_AVAILABLE && allow_avx2 && cpu_has_avx2();
+}
+
+void AttackBatch::rook_attacks(const Bitmask_t rooks[BATCH_SIZE], const Bitmask_t empty[BATCH_SIZE],
+	Bitmask_t output[BATCH_SIZE]) const {
+#if AVX2_AVAILABLE
+	if (use_avx2) return rook_attacks_avx2(rooks, empty, output);
+#endif
+	for (int i = 0; i < BATCH_SIZE; i++) output[i] = rook_fill(rooks[i], empty[i]);
+}
+
+void AttackBatch::bishop_attacks(const Bitmask_t bishops[BATCH_SIZE], const Bitmask_t empty[BATCH_SIZE],
+	Bitmask_t output[BATCH_SIZE]) const {
+#if AVX2_AVAILABLE
+	if (use_avx2) return bishop_attacks_avx2(bishops, empty, output);
+#endif
+	for (int i = 0; i < BATCH_SIZE; i++) output[i] = bishop_fill(bishops[i], empty[i]);
+}
+
+void AttackBatch::attacked_squares(const BitboardData * const positions[], const unsigned int n_positions,
+	const Color_t by, Bitmask_t output[]) const {
+	const int offset = (by == WHITE) ? 0 : BLACK_PAWN - WHITE_PAWN;
+
+	for (unsigned int first = 0; first < n_positions; first += BATCH_SIZE) {
+		// the last batch is padded with empty lanes
+		SideLanes lanes;
+		for (unsigned int i = 0; i < BATCH_SIZE; i++) {
+			if (first + i < n_positions) {
+				const BitboardData & data = *positions[first + i];
+				lanes.pawns[i] = data.pieces(WHITE_PAWN + offset);
+				lanes.knights[i] = data.pieces(WHITE_KNIGHT + offset);
+				lanes.orthogonal[i] = data.pieces(WHITE_ROOK + offset) | data.pieces(WHITE_QUEEN + offset);
+				lanes.diagonal[i] = data.pieces(WHITE_BISHOP + offset) | data.pieces(WHITE_QUEEN + offset);
+				lanes.king[i] = data.pieces(WHITE_KING + offset);
+				lanes.empty[i] = ~(data.white | data.black);
+			}
+			else {
+				lanes.pawns[i] = lanes.knights[i] = lanes.orthogonal[i] = 0;
+				lanes.diagonal[i] = lanes.king[i] = lanes.empty[i] = 0;
+			}
+		}
+
+		Bitmask_t attacks[BATCH_SIZE];
+#if AVX2_AVAILABLE
+		if (use_avx2) side_attacks_avx2(lanes, by == WHITE, attacks);
+		else
+#endif
+		side_attacks(lanes, by == WHITE, attacks);
+
+		for (unsigned int i = 0; i < BATCH_SIZE && first + i < n_positions; i++)
+			output[first + i] = attacks[i];
+	}
+}
+
+// Single sliders waiting to be filled, each in its own lane.
+// Several batches are queued before filling, so that the lanes have left the
+// store buffer by the time they are loaded into a vector.
+#define SLIDER_QUEUE_SIZE (16 * BATCH_SIZE)
+struct SliderQueue {
+	bool orthogonal;
+	Bitmask_t sliders[SLIDER_QUEUE_SIZE], empty[SLIDER_QUEUE_SIZE], own[SLIDER_QUEUE_SIZE];
+	Score_t weight[SLIDER_QUEUE_SIZE];
+	unsigned int position[SLIDER_QUEUE_SIZE];
+	unsigned int size;
+};
+
+// Fill every lane of a queue and add up the moves of each slider
+static void flush(const AttackBatch & batch, SliderQueue & queue, Score_t output[]) {
+	// pad the last batch with empty lanes
+	for (unsigned int i = queue.size; i % BATCH_SIZE; i++) queue.sliders[i] = queue.empty[i] = 0;
+	Bitmask_t attacks[SLIDER_QUEUE_SIZE];
+	for (unsigned int i = 0; i < queue.size; i += BATCH_SIZE) {
+		if (queue.orthogonal) batch.rook_attacks(queue.sliders + i, queue.empty + i, attacks + i);
+		else batch.bishop_attacks(queue.sliders + i, queue.empty + i, attacks + i);
+	}
+	for (unsigned int i = 0; i < queue.size; i++)
+		output[queue.position[i]] += queue.weight[i] * (signed)popcount(attacks[i] & ~queue.own[i]);
+	queue.size = 0;
+}
+
+static void push(const AttackBatch & batch, SliderQueue & queue, const unsigned int position,
+	const Coord_t square, const Bitmask_t empty, const Bitmask_t own, const Score_t weight,
+	Score_t output[]) {
+	queue.sliders[queue.size] = one << square;
+	queue.empty[queue.size] = empty;
+	queue.own[queue.size] = own;
+	queue.weight[queue.size] = weight;
+	queue.position[queue.size] = position;
+	if (++queue.size == SLIDER_QUEUE_SIZE) flush(batch, queue, output);
+}
+
+void AttackBatch::score_piece_position(const BitboardData * const positions[], const unsigned int n_positions,
+	const ScoreParams & sparams, Score_t output[]) const {
+	// Queens go in both queues, since their orthogonal and diagonal moves never overlap
+	SliderQueue queues[2];
+	queues[0].orthogonal = true;
+	queues[1].orthogonal = false;
+	queues[0].size = queues[1].size = 0;
+
+	for (unsigned int p = 0; p < n_positions; p++) {
+		const BitboardData & data = *positions[p];
+		const Bitmask_t empty = ~(data.white | data.black);
+		// squares not counted for each side: its own pieces and enemy pawn attacks
+		const Bitmask_t blocked[2] = {
+			data.white | MoveManager::bp_moves.attacks(data.pieces(BLACK_PAWN)),
+			data.black | MoveManager::wp_moves.attacks(data.pieces(WHITE_PAWN))
+		};
+		Score_t score = 0;
+
+		// Knights and kings only need a table lookup
+		for (int side = 0; side < 2; side++) {
+			const Piece_t offset = side ? BLACK_PAWN - WHITE_PAWN : 0;
+			const Bitmask_t own = blocked[side];
+			for (Bitmask_t knights = data.pieces(WHITE_KNIGHT + offset); knights; ) {
+				score += sparams.PIECE_MOBILITY[WHITE_KNIGHT + offset] *
+					(signed)popcount(MoveManager::n_moves.masks[pop_lsb(knights)] & ~own);
+			}
+			for (Bitmask_t kings = data.pieces(WHITE_KING + offset); kings; ) {
+				score += sparams.PIECE_MOBILITY[WHITE_KING + offset] *
+					(signed)popcount(MoveManager::k_moves.masks[pop_lsb(kings)] & ~own);
+			}
+		}
+		output[p] = score;
+
+		// Sliders are filled a batch at a time
+		for (int side = 0; side < 2; side++) {
+			const Piece_t offset = side ? BLACK_PAWN - WHITE_PAWN : 0;
+			const Bitmask_t own = blocked[side];
+			for (Piece_t piece = WHITE_BISHOP + offset; piece <= WHITE_QUEEN + offset; piece++) {
+				const Score_t weight = sparams.PIECE_MOBILITY[piece];
+				for (Bitmask_t sliders = data.pieces(piece); sliders; ) {
+					Coord_t square = pop_lsb(sliders);
+					if (piece != WHITE_BISHOP + offset)
+						push(*this, queues[0], p, square, empty, own, weight, output);
+					if (piece != WHITE_ROOK + offset)
+						push(*this, queues[1], p, square, empty, own, weight, output);
+				}
+			}
+		}
+	}
+
+	if (queues[0].size) flush(*this, queues[0], output);
+	if (queues[1].size) flush(*this, queues[1], output);
+
+	// the weights are middlegame/endgame pairs, blended once all are summed
+	for (unsigned int p = 0; p < n_positions; p++) output[p] = taper(output[p], positions[p]->phase);
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+/*******************************************************************************
+* Deep Winkelman
+*
+* Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
+* 9 June 2017
+*
+* Attack sets for several positions or pieces at once.
+*
+* Slider attacks are found with Kogge-Stone fills, which only shift and mask,
+* so four 64-bit lanes fit in one AVX2 register. Lanes are independent: a lane
+* can hold all of one side's sliders in a position (for attack maps) or a
+* single piece (for counting the moves of each piece). Without AVX2 the same
+* fills run on one lane at a time.
+*/
+
+#ifndef DEEP_WINKELMAN_BATCH
+#define DEEP_WINKELMAN_BATCH
+
+#include "bitboard.h"
+
+// Number of lanes processed together
+#define BATCH_SIZE 4
+
+// AVX2 is only available on x86 processors that support it.
+// Whether the processor running the program has it must be checked at runtime.
+#if defined(_M_X64) || defined(__x86_64__)
+#define AVX2_AVAILABLE 1
+#else
+#define AVX2_AVAILABLE 0
+#endif
+
+class AttackBatch {
+protected:
+	bool use_avx2;
+
+public:
+	AttackBatch(const bool allow_avx2 = BATCH_ALLOW_AVX2);
+
+	// Attacks of sliders in each lane, stopped by the first non-empty square
+	void rook_attacks(const Bitmask_t rooks[BATCH_SIZE], const Bitmask_t empty[BATCH_SIZE],
+		Bitmask_t output[BATCH_SIZE]) const;
+	void bishop_attacks(const Bitmask_t bishops[BATCH_SIZE], const Bitmask_t empty[BATCH_SIZE],
+		Bitmask_t output[BATCH_SIZE]) const;
+
+	// Squares attacked by a colour in each position.
+	// Any number of positions can be given.
+	void attacked_squares(const BitboardData * const positions[], const unsigned int n_positions,
+		const Color_t by, Bitmask_t output[]) const;
+
+	// Score of the mobility of the pieces in each position, the same as
+	// Bitboard::score_piece_position. Any number of positions can be given.
+	void score_piece_position(const BitboardData * const positions[], const unsigned int n_positions,
+		const ScoreParams & sparams, Score_t output[]) const;
+
+	// Whether the fills are using AVX2 instead of one lane at a time
+	inline bool is_using_avx2() const {
+		return use_avx2;
+	}
+};
+
+#endif
\ No newline at end of file
@@ -8,218 +8,623 @@
 */
 
 #include "bitboard.h"
+#include "util.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <random>
 
 Hash_t BitboardData::zobrist_keys[13][64];
-bool BitboardData::is_zobrist_inited = false;
-void BitboardData::init_zobrist() {
-	std::random_device rd;
-	std::mt19937 gen(rd());
-	std::uniform_int_distribution<Hash_t> dis(0, 0xffffffffffffffff);
-	for (int i = 0; i < 13; i++) {
+Hash_t BitboardData::zobrist_castling[16];
+Hash_t BitboardData::zobrist_ep[8];
+Hash_t BitboardData::zobrist_side;
+
+// The keys are the outputs of a 64-bit Mersenne Twister from this seed, whose
+// sequence the standard fixes exactly, taken in order: each piece from white
+// pawn to black king on each square from a1 to h8, then white kingside,
+// white queenside, black kingside and black queenside castling, then the en
+// passant files from a to h, then white to move.
+static const uint64_t ZOBRIST_SEED = 0x44656570576b6c6eULL;
+
+bool BitboardData::init_zobrist() {
+	std::mt19937_64 gen(ZOBRIST_SEED);
+	for (int j = 0; j < 64; j++) {
+		zobrist_keys[NO_PIECE][j] = 0;
+	}
+	for (int i = WHITE_PAWN; i <= BLACK_KING; i++) {
 		for (int j = 0; j < 64; j++) {
-			zobrist_keys[i][j] = dis(gen);
+			zobrist_keys[i][j] = gen();
+		}
+	}
+	Hash_t castling_keys[4];
+	for (int i = 0; i < 4; i++) {
+		castling_keys[i] = gen();
+	}
+	for (int castling = 0; castling < 16; castling++) {
+		zobrist_castling[castling] = 0;
+		for (int i = 0; i < 4; i++) {
+			if ((castling >> i) & 1) zobrist_castling[castling] ^= castling_keys[i];
 		}
 	}
+	for (int i = 0; i < 8; i++) {
+		zobrist_ep[i] = gen();
+	}
+	zobrist_side = gen();
+	return true;
 }
 
-MoveManager Bitboard::move_manager = MoveManager();
+const MoveManager Bitboard::move_manager = MoveManager();
+const ScoreParams Bitboard::sparams = ScoreParams();
+thread_local MaterialTable Bitboard::material_table;
+thread_local PawnTable Bitboard::pawn_table;
+EvalCache Bitboard::eval_cache(EVAL_CACHE_BITS);
+thread_local unsigned long long Bitboard::lazy_evaluations = 0;
+thread_local unsigned long long Bitboard::lazy_cutoffs = 0;
 
-Bitboard::Bitboard(const Piece_t squares[64], const Color_t color, const Castling_t castling = 15) {
-	// initialize squares
+static const Piece_t DEFAULT_POS[64] = {
+	4,2,3,5,6,3,2,4,
+	1,1,1,1,1,1,1,1,
+	0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,
+	0,0,0,0,0,0,0,0,
+	7,7,7,7,7,7,7,7,
+	10,8,9,11,12,9,8,10 };
+
+Position::Position() : Position(DEFAULT_POS, WHITE, 15) {
+
+}
+
+Position::Position(const Piece_t squares[64], const Color_t color, const Castling_t castling,
+	const Coord_t ep, const uint16_t halfmove) {
 	for (int i = 0; i < 64; i++) {
 		this->squares[i] = squares[i];
 	}
+	this->color = color;
+	this->castling = castling;
+	this->ep = ep;
+	this->halfmove = halfmove;
+}
 
+Bitboard::Bitboard(const Piece_t squares[64], const Color_t color, const Castling_t castling = 15,
+	const Coord_t ep_target, const uint16_t halfmove) {
 	depth = 0;
+	BitboardData & data = history[depth];
+
+	// initialize squares
+	for (int i = 0; i < 64; i++) {
+#if COPY_MAKE
+		data.squares[i] = squares[i];
+#else
+		this->squares[i] = squares[i];
+#endif
+	}
 
 	// initialize bitboards
 	for (int i = 0; i < 64; i++) {
-		if (squares[i] < BLACK_PAWN && squares[i] != NO_PIECE) {
-			history[depth].white |= one << i;
-			if (squares[i] == WHITE_PAWN) history[depth].wpawns |= one << i;
-		}
-		else if (squares[i] != NO_PIECE) {
-			history[depth].black |= one << i;
-			if (squares[i] == BLACK_PAWN) history[depth].bpawns |= one << i;
-		}
-		history[depth].pieces[squares[i]] |= one << i;
+		if (squares[i] == NO_PIECE) continue;
+		if (squares[i] < BLACK_PAWN) data.white |= one << i;
+		else data.black |= one << i;
+		data.types[BitboardData::type_index(squares[i])] |= one << i;
 	}
 
-	// initialize hash and piece score
+	// initialize hashes of the pieces, piece and material scores, phase and kings
 	for (int i = 0; i < 64; i++) {
-		history[depth].hash ^= BitboardData::zobrist_keys[squares[i]][i];
-		history[depth].piece_score += sparams.PIECE_VALUES[squares[i]];
+		data.hash ^= BitboardData::zobrist_keys[squares[i]][i];
+		data.piece_score += sparams.PIECE_VALUES[squares[i]];
+		data.positioning_score += sparams.PIECE_SQUARES[squares[i]][i];
+		data.material_key += MATERIAL_UNITS[squares[i]];
+		data.phase += PHASE_UNITS[squares[i]];
+		data.pawn_key ^= BitboardData::pawn_key_of(squares[i], i);
+		if (squares[i] == WHITE_KING) data.white_king = i;
+		if (squares[i] == BLACK_KING) data.black_king = i;
 	}
 
 	// initialize castling, en passant, color
-	history[depth].ep = BitboardMove(NO_MOVE, NO_MOVE);
-	history[depth].castling = WHITE_OO | WHITE_OOO | BLACK_OO | BLACK_OOO;
-	history[depth].color = color;
+	data.ep = NO_MOVE;
+	data.castling = castling;
+	data.color = color;
+	data.halfmove = halfmove;
+
+	// same as make: only keep en passant if a pawn can capture
+	if (ep_target < 64) {
+		const Coord_t ep_pawn = (color == WHITE) ? ep_target - 8 : ep_target + 8;
+		const Bitmask_t capturers = (color == WHITE) ?
+			pawn_attacks<BLACK>(one << ep_target) & data.pieces(WHITE_PAWN) :
+			pawn_attacks<WHITE>(one << ep_target) & data.pieces(BLACK_PAWN);
+		if (capturers && squares[ep_pawn] == ((color == WHITE) ? BLACK_PAWN : WHITE_PAWN))
+			data.ep = ep_target;
+	}
+
+	// hash the rest of the state
+	data.hash ^= BitboardData::zobrist_castling[castling];
+	if (data.ep != NO_MOVE) data.hash ^= BitboardData::zobrist_ep[data.ep % 8];
+	if (color == WHITE) data.hash ^= BitboardData::zobrist_side;
+
+#if INCREMENTAL_ATTACKS
+	const Bitmask_t occupancy = history[depth].white | history[depth].black;
+	for (int i = 0; i < 64; i++) piece_attacks[i] = compute_piece_attacks(i, occupancy);
+	attack_log_size = 0;
+#endif
+	update_attacks();
 }
 
 Bitboard::Bitboard() : Bitboard(DEFAULT_POS, WHITE) {
 
 }
 
+Bitboard::Bitboard(const Position & position) :
+	Bitboard(position.squares, position.color, position.castling, position.ep, position.halfmove) {
 
+}
 
-std::vector<Move> Bitboard::get_moves() const {
-	// capturing moves from MoveMananger
-	static MoveList * sets_list[256];
-	static MoveList * promotion_sets_list[8];
-	static Coord_t square_list[256], promotion_square_list[8];
-	static int n_sets, n_moves, n_promotion_sets, n_promotion_moves;
-	n_sets = n_moves = n_promotion_sets = n_promotion_moves = 0;
-
-	// gather sets of possible moves
-	static Bitmask_t friendly, enemy;
-	// white to move
-	if (history[depth].color == WHITE) {
-		friendly = history[depth].white;
-		enemy = history[depth].black;
-
-		static int i;
-		for (int i = 0; i < 64; i++) {
-			switch (squares[i]) {
-			case WHITE_PAWN:
-				// check for promotion
-				if (i < 48) {
-					square_list[n_sets] = i;
-					sets_list[n_sets++] = &(move_manager.wp_moves.get_movelist(i, friendly, enemy));
-				}
-				else {
-					promotion_square_list[n_promotion_sets] = i;
-					promotion_sets_list[n_promotion_sets++] =
-						&(move_manager.wp_moves.get_movelist(i, friendly, enemy));
-				}
-				break;
-			case WHITE_KNIGHT:
-				square_list[n_sets] = i;
-				sets_list[n_sets++] = &(move_manager.n_moves.get_movelist(i, friendly, enemy));
-				break;
-			case WHITE_BISHOP:
-				square_list[n_sets] = square_list[n_sets + 1] = i;
-				sets_list[n_sets++] = &(move_manager.d1_moves.get_movelist(i, friendly, enemy));
-				sets_list[n_sets++] = &(move_manager.d2_moves.get_movelist(i, friendly, enemy));
-				break;
-			case WHITE_ROOK:
-				square_list[n_sets] = square_list[n_sets + 1] = i;
-				sets_list[n_sets++] = &(move_manager.h_moves.get_movelist(i, friendly, enemy));
-				sets_list[n_sets++] = &(move_manager.v_moves.get_movelist(i, friendly, enemy));
-				break;
-			case WHITE_QUEEN:
-				square_list[n_sets] = square_list[n_sets + 1] =
-					square_list[n_sets + 2] = square_list[n_sets + 3] = i;
-				sets_list[n_sets++] = &(move_manager.h_moves.get_movelist(i, friendly, enemy));
-				sets_list[n_sets++] = &(move_manager.v_moves.get_movelist(i, friendly, enemy));
-				sets_list[n_sets++] = &(move_manager.d1_moves.get_movelist(i, friendly, enemy));
-				sets_list[n_sets++] = &(move_manager.d2_moves.get_movelist(i, friendly, enemy));
-				break;
-			case WHITE_KING:
-				square_list[n_sets] = i;
-				sets_list[n_sets++] = &(move_manager.k_moves.get_movelist(i, friendly, enemy));
-				break;
-			}
-		}
+Position Bitboard::position() const {
+	const BitboardData & data = history[depth];
+	Piece_t grid[64];
+	for (int i = 0; i < 64; i++) {
+		grid[i] = piece_on(i);
+	}
+	return Position(grid, data.color, data.castling, data.ep, data.halfmove);
+}
+
+
+
+template<Color_t By>
+void Bitboard::side_pieces(Bitmask_t & pawns, Bitmask_t & knights, Bitmask_t & orthogonal,
+	Bitmask_t & diagonal, Coord_t & king) const {
+	const BitboardData & data = history[depth];
+	// black piece codes are offset from the white ones
+	const int offset = (By == WHITE) ? 0 : BLACK_PAWN - WHITE_PAWN;
+
+	pawns = data.pieces(WHITE_PAWN + offset);
+	knights = data.pieces(WHITE_KNIGHT + offset);
+	orthogonal = data.pieces(WHITE_ROOK + offset) | data.pieces(WHITE_QUEEN + offset);
+	diagonal = data.pieces(WHITE_BISHOP + offset) | data.pieces(WHITE_QUEEN + offset);
+	king = (By == WHITE) ? data.white_king : data.black_king;
+}
+
+template<Color_t By>
+Bitmask_t Bitboard::attackers(const Coord_t square, const Bitmask_t occupancy) const {
+	Bitmask_t pawns, knights, orthogonal, diagonal;
+	Coord_t king;
+	side_pieces<By>(pawns, knights, orthogonal, diagonal, king);
+
+	// a pawn attacks the square if a pawn of the other colour on the square would attack it
+	return (pawn_attacks<-By>(one << square) & pawns)
+		| (move_manager.n_moves.masks[square] & knights)
+		| (move_manager.k_moves.masks[square] & (one << king))
+		| (move_manager.slider_moves.rook_attacks(square, occupancy) & orthogonal)
+		| (move_manager.slider_moves.bishop_attacks(square, occupancy) & diagonal);
+}
+
+template<Color_t By>
+Bitmask_t Bitboard::attacks(const Bitmask_t occupancy) const {
+	Bitmask_t pawns, knights, orthogonal, diagonal;
+	Coord_t king;
+	side_pieces<By>(pawns, knights, orthogonal, diagonal, king);
+
+	Bitmask_t attacked = pawn_attacks<By>(pawns);
+	attacked |= move_manager.k_moves.masks[king];
+	while (knights) attacked |= move_manager.n_moves.masks[pop_lsb(knights)];
+	while (orthogonal) attacked |= move_manager.slider_moves.rook_attacks(pop_lsb(orthogonal), occupancy);
+	while (diagonal) attacked |= move_manager.slider_moves.bishop_attacks(pop_lsb(diagonal), occupancy);
+	return attacked;
+}
+
+template<Color_t By>
+Bitmask_t Bitboard::attacked_squares() const {
+#if CACHE_ATTACK_MAPS
+	return history[depth].attacks[(By == WHITE) ? 0 : 1];
+#else
+	const BitboardData & data = history[depth];
+	return attacks<By>(data.white | data.black);
+#endif
+}
+
+void Bitboard::update_attacks() {
+#if CACHE_ATTACK_MAPS && INCREMENTAL_ATTACKS
+	// the attacks of each piece are already known, but pawns are faster to do together
+	BitboardData & data = history[depth];
+	data.attacks[0] = pawn_attacks<WHITE>(data.pieces(WHITE_PAWN));
+	data.attacks[1] = pawn_attacks<BLACK>(data.pieces(BLACK_PAWN));
+	for (Bitmask_t pieces = data.white & ~data.pieces(WHITE_PAWN); pieces; ) data.attacks[0] |= piece_attacks[pop_lsb(pieces)];
+	for (Bitmask_t pieces = data.black & ~data.pieces(BLACK_PAWN); pieces; ) data.attacks[1] |= piece_attacks[pop_lsb(pieces)];
+#elif CACHE_ATTACK_MAPS
+	BitboardData & data = history[depth];
+	const Bitmask_t occupancy = data.white | data.black;
+	data.attacks[0] = attacks<WHITE>(occupancy);
+	data.attacks[1] = attacks<BLACK>(occupancy);
+#endif
+}
+
+Bitmask_t Bitboard::attackers_to(const Coord_t square, const Bitmask_t occupancy) const {
+	return attackers<WHITE>(square, occupancy) | attackers<BLACK>(square, occupancy);
+}
+
+bool Bitboard::is_square_attacked(const Coord_t square, const Color_t by) const {
+#if CACHE_ATTACK_MAPS
+	return (attacked_squares(by) >> square) & 1;
+#else
+	const BitboardData & data = history[depth];
+	if (by == WHITE) return attackers<WHITE>(square, data.white | data.black) != 0;
+	else return attackers<BLACK>(square, data.white | data.black) != 0;
+#endif
+}
+
+Bitmask_t Bitboard::attacked_squares(const Color_t by) const {
+	if (by == WHITE) return attacked_squares<WHITE>();
+	else return attacked_squares<BLACK>();
+}
+
+Score_t Bitboard::see(const Move move) const {
+	if (move.is_castling()) return 0;
+
+	const BitboardData & data = history[depth];
+	const Coord_t start = move.start(), end = move.end();
+	const Score_t * values = sparams.PIECE_VALUES;
+	Bitmask_t occupancy = (data.white | data.black) & ~(one << start);
+
+	// Material won after each capture in the sequence, for the side that made it
+	Score_t gain[32];
+	Piece_t on_square = piece_on(start);
+	if (move.is_en_passant()) {
+		gain[0] = values[WHITE_PAWN];
+		occupancy &= ~(one << (end - 8 * data.color));
 	}
 	else {
-		friendly = history[depth].black;
-		enemy = history[depth].white;
-
-		static int i;
-		for (int i = 0; i < 64; i++) {
-			switch (squares[i]) {
-			case BLACK_PAWN:
-				// check for promotion
-				if (i >= 16) {
-					square_list[n_sets] = i;
-					sets_list[n_sets++] = &(move_manager.bp_moves.get_movelist(i, friendly, enemy));
-				}
-				else {
-					promotion_square_list[n_promotion_sets] = i;
-					promotion_sets_list[n_promotion_sets++] =
-						&(move_manager.bp_moves.get_movelist(i, friendly, enemy));
-				}
-				break;
-			case BLACK_KNIGHT:
-				square_list[n_sets] = i;
-				sets_list[n_sets++] = &(move_manager.n_moves.get_movelist(i, friendly, enemy));
-				break;
-			case BLACK_BISHOP:
-				square_list[n_sets] = square_list[n_sets + 1] = i;
-				sets_list[n_sets++] = &(move_manager.d1_moves.get_movelist(i, friendly, enemy));
-				sets_list[n_sets++] = &(move_manager.d2_moves.get_movelist(i, friendly, enemy));
-				break;
-			case BLACK_ROOK:
-				square_list[n_sets] = square_list[n_sets + 1] = i;
-				sets_list[n_sets++] = &(move_manager.h_moves.get_movelist(i, friendly, enemy));
-				sets_list[n_sets++] = &(move_manager.v_moves.get_movelist(i, friendly, enemy));
-				break;
-			case BLACK_QUEEN:
-				square_list[n_sets] = square_list[n_sets + 1] =
-					square_list[n_sets + 2] = square_list[n_sets + 3] = i;
-				sets_list[n_sets++] = &(move_manager.h_moves.get_movelist(i, friendly, enemy));
-				sets_list[n_sets++] = &(move_manager.v_moves.get_movelist(i, friendly, enemy));
-				sets_list[n_sets++] = &(move_manager.d1_moves.get_movelist(i, friendly, enemy));
-				sets_list[n_sets++] = &(move_manager.d2_moves.get_movelist(i, friendly, enemy));
-				break;
-			case BLACK_KING:
-				square_list[n_sets] = i;
-				sets_list[n_sets++] = &(move_manager.k_moves.get_movelist(i, friendly, enemy));
-				break;
-			}
+		gain[0] = std::abs(values[piece_on(end)]);
+	}
+	if (move.is_promotion()) {
+		on_square = move.promotion_piece();
+		gain[0] += std::abs(values[on_square]) - values[WHITE_PAWN];
+	}
+
+	// Recapture with the least valuable piece each time. Taking a piece off
+	// can uncover a slider behind it, so the attackers are found again each time.
+	int n = 0;
+	Color_t side = data.color;
+	while (n < 31) {
+		side = -side;
+		const Bitmask_t side_attackers = attackers_to(end, occupancy) & occupancy
+			& ((side == WHITE) ? data.white : data.black);
+		if (!side_attackers) break;
+
+		Piece_t piece = (side == WHITE) ? WHITE_PAWN : BLACK_PAWN;
+		while (!(data.pieces(piece) & side_attackers)) piece++;
+
+		n++;
+		gain[n] = std::abs(values[on_square]) - gain[n - 1];
+		on_square = piece;
+		occupancy &= ~(one << bitscan(data.pieces(piece) & side_attackers));
+	}
+
+	// Going backwards, each side only recaptures if it does better than stopping
+	while (n > 0) {
+		n--;
+		if (-gain[n + 1] < gain[n]) gain[n] = -gain[n + 1];
+	}
+	return gain[0];
+}
+
+template<Color_t Us>
+Bitmask_t Bitboard::checkers() const {
+	const BitboardData & data = history[depth];
+	const Coord_t king = (Us == WHITE) ? data.white_king : data.black_king;
+	return attackers<-Us>(king, data.white | data.black);
+}
+
+template<Color_t Us>
+Bitmask_t Bitboard::pinned_pieces(Bitmask_t pin_rays[64]) const {
+	const BitboardData & data = history[depth];
+	const Bitmask_t friendly = (Us == WHITE) ? data.white : data.black;
+	const Bitmask_t enemy = (Us == WHITE) ? data.black : data.white;
+	const Coord_t king = (Us == WHITE) ? data.white_king : data.black_king;
+
+	Bitmask_t pawns, knights, orthogonal, diagonal;
+	Coord_t enemy_king;
+	side_pieces<-Us>(pawns, knights, orthogonal, diagonal, enemy_king);
+
+	// Sliders that would attack the king if only enemy pieces were on the board
+	// pin a friendly piece if it is the only piece in between
+	Bitmask_t pinned = 0;
+	Bitmask_t snipers =
+		(move_manager.slider_moves.rook_attacks(king, enemy) & orthogonal) |
+		(move_manager.slider_moves.bishop_attacks(king, enemy) & diagonal);
+	while (snipers) {
+		Coord_t sniper = pop_lsb(snipers);
+		Bitmask_t ray = move_manager.slider_moves.between(king, sniper);
+		Bitmask_t blockers = ray & (friendly | enemy);
+		if (blockers && !(blockers & (blockers - 1)) && (blockers & friendly)) {
+			pinned |= blockers;
+			pin_rays[bitscan(blockers)] = ray | (one << sniper);
 		}
 	}
+	return pinned;
+}
+
+bool Bitboard::in_check() const {
+	if (history[depth].color == WHITE) return checkers<WHITE>() != 0;
+	else return checkers<BLACK>() != 0;
+}
+
+bool Bitboard::has_pieces(const Color_t color) const {
+	const BitboardData & data = history[depth];
+	if (color == WHITE) return (data.white & ~data.pieces(WHITE_PAWN) & ~data.pieces(WHITE_KING)) != 0;
+	else return (data.black & ~data.pieces(BLACK_PAWN) & ~data.pieces(BLACK_KING)) != 0;
+}
+
+GameState_t Bitboard::game_state() const {
+	MoveBuffer<MAX_MOVES> moves;
+	get_moves(moves);
+	if (moves.empty()) return in_check() ? GAME_CHECKMATE : GAME_STALEMATE;
+	return is_draw() ? GAME_DRAW : GAME_IN_PROGRESS;
+}
+
+bool Bitboard::is_draw() const {
+	const BitboardData & data = history[depth];
+	if (data.halfmove >= 100) return true;
 
-	// count up number of moves and make an output vector
-	static int i;
-	for (i = 0; i < n_sets; i++) {
-		n_moves += sets_list[i]->n_coords;
+	// the history stack holds the hash of every earlier position
+	const int oldest = std::max(depth - (int)data.halfmove, 0);
+	for (int i = depth - 4; i >= oldest; i -= 2) {
+		if (history[i].hash == data.hash) return true;
 	}
-	for (i = 0; i < n_promotion_sets; i++) {
-		n_promotion_moves += promotion_sets_list[i]->n_coords;
+	return false;
+}
+
+std::vector<Move> Bitboard::get_moves() const {
+	MoveBuffer<MAX_MOVES> moves;
+	get_moves(moves, GEN_ALL);
+	return std::vector<Move>(moves.begin(), moves.end());
+}
+
+void Bitboard::get_moves(MoveBuffer<MAX_MOVES> & output, const MoveGen_t gen) const {
+	if (history[depth].color == WHITE) generate_moves<WHITE>(output, gen);
+	else generate_moves<BLACK>(output, gen);
+}
+
+template<Color_t Us>
+void Bitboard::generate_moves(MoveBuffer<MAX_MOVES> & output, const MoveGen_t gen) const {
+	// Everything that depends on the side to move is a constant
+	const bool white = Us == WHITE;
+	const int up = white ? 8 : -8;
+	const Piece_t offset = white ? 0 : BLACK_PAWN - WHITE_PAWN;
+	const Bitmask_t second_rank = white ? 0x000000000000ff00 : 0x00ff000000000000;
+	const Bitmask_t seventh_rank = white ? 0x00ff000000000000 : 0x000000000000ff00;
+
+	const BitboardData & data = history[depth];
+	const Bitmask_t friendly = white ? data.white : data.black;
+	const Bitmask_t enemy = white ? data.black : data.white;
+	const Bitmask_t all_pieces = friendly | enemy;
+	const Coord_t king = white ? data.white_king : data.black_king;
+
+	const Bitmask_t checkers = attackers<-Us>(king, all_pieces);
+
+	// Squares attacked by the enemy, only needed for quiet king moves and castling.
+	// In check the king is removed so that it cannot step back along a checking ray;
+	// otherwise no slider sees through the king and the board's own map will do.
+	const Bitmask_t king_occupancy = all_pieces & ~(one << king);
+	Bitmask_t attacked = 0;
+	if (gen & GEN_QUIETS)
+		attacked = checkers ? attacks<-Us>(king_occupancy) : attacked_squares<-Us>();
+
+	// Squares that non-king moves must land on: anywhere when not in check,
+	// blocking or capturing a single checker, and nowhere in double check
+	Bitmask_t check_mask = ~(Bitmask_t)0;
+	if (checkers) {
+		Coord_t checker = bitscan(checkers);
+		if (checkers & (checkers - 1)) check_mask = 0;
+		else check_mask = move_manager.slider_moves.between(king, checker) | checkers;
 	}
-	std::vector<Move> output(n_moves + n_promotion_moves * 4);
 
-	// write moves to output vector
-	static int move_it, row, col;
-	for (move_it = 0, row = 0; row < n_sets; row++) {
-		for (col = 0; col < sets_list[row]->n_coords; col++) {
-			output.at(move_it++) = Move(square_list[row], sets_list[row]->coords[col]);
+	// Pinned pieces can only move along the line between the king and pinner
+	Bitmask_t pin_rays[64];
+	const Bitmask_t pinned = pinned_pieces<Us>(pin_rays);
+
+	// Squares that the requested kinds of moves can land on.
+	// Promotions are all counted as captures, so pawns on the last rank
+	// are handled separately.
+	Bitmask_t gen_mask = 0;
+	if (gen & GEN_CAPTURES) gen_mask |= enemy;
+	if (gen & GEN_QUIETS) gen_mask |= ~all_pieces;
+	const Bitmask_t promotion_mask = (gen & GEN_CAPTURES) ? ~(Bitmask_t)0 : 0;
+
+	// Pieces in order of square (only the king can move in double check)
+	Bitmask_t pieces = check_mask ? friendly : one << king;
+	while (pieces) {
+		Coord_t i = pop_lsb(pieces);
+		Bitmask_t targets;
+		const Piece_t piece = piece_on(i) - offset;
+		switch (piece) {
+		case WHITE_KING:
+			// king moves cannot be blocked, only avoided
+			targets = move_manager.k_moves.masks[i] & ~friendly & ~attacked & gen_mask;
+			while (targets) {
+				Coord_t end = pop_lsb(targets);
+				// without the attack map, captures are checked one at a time
+				if ((gen & GEN_QUIETS) || !attackers<-Us>(end, king_occupancy))
+					output.push_back(Move(i, end));
+			}
+			continue;
+		case WHITE_PAWN:
+			targets = ~all_pieces & (one << (i + up));
+			if (targets && (second_rank & (one << i))) targets |= ~all_pieces & (one << (i + 2 * up));
+			targets |= pawn_attacks<Us>(one << i) & enemy;
+			break;
+#if INCREMENTAL_ATTACKS
+		case WHITE_KNIGHT:
+		case WHITE_BISHOP:
+		case WHITE_ROOK:
+		case WHITE_QUEEN:
+			targets = piece_attacks[i];
+			break;
+#else
+		case WHITE_KNIGHT:
+			targets = move_manager.n_moves.masks[i];
+			break;
+		case WHITE_BISHOP:
+			targets = move_manager.slider_moves.bishop_attacks(i, all_pieces);
+			break;
+		case WHITE_ROOK:
+			targets = move_manager.slider_moves.rook_attacks(i, all_pieces);
+			break;
+		case WHITE_QUEEN:
+			targets = move_manager.slider_moves.queen_attacks(i, all_pieces);
+			break;
+#endif
+		default:
+			targets = 0;
+			break;
+		}
+		targets &= ~friendly & check_mask;
+		if (pinned & (one << i)) targets &= pin_rays[i];
+
+		if (piece == WHITE_PAWN && (seventh_rank & (one << i))) {
+			// promotions, in order of piece code
+			const Piece_t knight = WHITE_KNIGHT + offset;
+			targets &= promotion_mask;
+			while (targets) {
+				Coord_t end = pop_lsb(targets);
+				for (Piece_t promotion = knight; promotion <= knight + 3; promotion++)
+					output.push_back(Move(i, end, promotion));
+			}
+		}
+		else {
+			targets &= gen_mask;
+			while (targets) output.push_back(Move(i, pop_lsb(targets)));
 		}
 	}
-	for (move_it = 0, row = 0; row < n_promotion_sets; row++) {
-		for (col = 0; col < promotion_sets_list[row]->n_coords; col++) {
-			output.at(move_it++) = Move(
-				promotion_square_list[row],
-				promotion_sets_list[row]->coords[col],
-				WHITE_KNIGHT);
+
+	// Castling cannot be out of, through, or into check
+	const Castling_t castling = data.castling;
+	if (!checkers && (gen & GEN_QUIETS)) {
+		if (white) {
+			if (castling & WHITE_OO && !(all_pieces & WHITE_OO_MASK) &&
+				!(attacked & WHITE_OO_MASK))
+				output.push_back(move_white_OO);
+			if (castling & WHITE_OOO && !(all_pieces & WHITE_OOO_MASK) &&
+				!(attacked & WHITE_OOO_KING_MASK))
+				output.push_back(move_white_OOO);
+		}
+		else {
+			if (castling & BLACK_OO && !(all_pieces & BLACK_OO_MASK) &&
+				!(attacked & BLACK_OO_MASK))
+				output.push_back(move_black_OO);
+			if (castling & BLACK_OOO && !(all_pieces & BLACK_OOO_MASK) &&
+				!(attacked & BLACK_OOO_KING_MASK))
+				output.push_back(move_black_OOO);
 		}
 	}
 
-	// handle castling and en_passant moves
-	static Castling_t castling;
-	static Bitmask_t all_pieces;
-	all_pieces = history[depth].white | history[depth].black;
-	castling = history[depth].castling;
-	if (history[depth].color == WHITE) {
-		if (castling & WHITE_OO && !(all_pieces & WHITE_OO_MASK))
-			output.push_back(move_white_OO);
-		if (castling & WHITE_OOO && !(all_pieces & WHITE_OOO_MASK))
-			output.push_back(move_white_OOO);
+	if (gen & GEN_CAPTURES) generate_en_passant<Us>(output, checkers);
+}
+
+template<Color_t Us>
+void Bitboard::generate_en_passant(MoveBuffer<MAX_MOVES> & output, const Bitmask_t checkers) const {
+	const BitboardData & data = history[depth];
+	if (data.ep == NO_MOVE) return;
+
+	const Piece_t pawn = (Us == WHITE) ? WHITE_PAWN : BLACK_PAWN;
+	const Bitmask_t all_pieces = data.white | data.black;
+	const Coord_t king = (Us == WHITE) ? data.white_king : data.black_king;
+	Bitmask_t enemy_pawns, enemy_knights, enemy_orthogonal, enemy_diagonal;
+	Coord_t enemy_king;
+	side_pieces<-Us>(enemy_pawns, enemy_knights, enemy_orthogonal, enemy_diagonal, enemy_king);
+
+	// En passant can uncover a check along the rank of both pawns,
+	// so check the sliders again with both pawns removed
+	const Coord_t target = data.ep, captured = (Us == WHITE) ? target - 8 : target + 8;
+	Bitmask_t capturers = pawn_attacks<-Us>(one << target) & data.pieces(pawn);
+	while (capturers) {
+		Coord_t start = pop_lsb(capturers);
+		Bitmask_t after = (all_pieces & ~(one << start) & ~(one << captured)) | (one << target);
+		Bitmask_t exposed =
+			(move_manager.slider_moves.rook_attacks(king, after) & enemy_orthogonal) |
+			(move_manager.slider_moves.bishop_attacks(king, after) & enemy_diagonal) |
+			(checkers & (enemy_knights | enemy_pawns) & ~(one << captured));
+		if (!exposed) output.push_back(Move(start, target, MOVE_EN_PASSANT));
 	}
-	else {
-		if (castling & BLACK_OO && !(all_pieces & BLACK_OO_MASK))
-			output.push_back(move_black_OO);
-		if (castling & BLACK_OOO && !(all_pieces & BLACK_OOO_MASK))
-			output.push_back(move_black_OOO);
+}
+
+void Bitboard::generate_captures(MoveBuffer<MAX_MOVES> & output) const {
+	get_moves(output, GEN_CAPTURES);
+}
+
+void Bitboard::generate_evasions(MoveBuffer<MAX_MOVES> & output) const {
+	if (history[depth].color == WHITE) generate_evasions<WHITE>(output);
+	else generate_evasions<BLACK>(output);
+}
+
+template<Color_t Us>
+void Bitboard::generate_evasions(MoveBuffer<MAX_MOVES> & output) const {
+	const bool white = Us == WHITE;
+	const Piece_t offset = white ? 0 : BLACK_PAWN - WHITE_PAWN;
+	const Bitmask_t fourth_rank = white ? 0x00000000ff000000 : 0x000000ff00000000;
+	const Bitmask_t last_rank = white ? 0xff00000000000000 : 0x00000000000000ff;
+
+	const BitboardData & data = history[depth];
+	const Bitmask_t friendly = white ? data.white : data.black;
+	const Bitmask_t all_pieces = data.white | data.black;
+	const Coord_t king = white ? data.white_king : data.black_king;
+
+	const Bitmask_t checkers = attackers<-Us>(king, all_pieces);
+	if (!checkers) return;
+
+	// The king steps out of check, tested against the board without the king
+	// so that it cannot step back along a checking ray
+	const Bitmask_t king_occupancy = all_pieces & ~(one << king);
+	Bitmask_t targets = move_manager.k_moves.masks[king] & ~friendly;
+	while (targets) {
+		Coord_t end = pop_lsb(targets);
+		if (!attackers<-Us>(end, king_occupancy)) output.push_back(Move(king, end));
+	}
+
+	// Only the king can move out of double check
+	if (checkers & (checkers - 1)) return;
+
+	// Other pieces capture the checker or block it, but never when pinned
+	// (a pinned piece cannot leave its own line to reach the checking line).
+	// Work backwards from each of those few squares to the pieces that reach it.
+	const Coord_t checker = bitscan(checkers);
+	Bitmask_t pin_rays[64];
+	const Bitmask_t movable = friendly & ~pinned_pieces<Us>(pin_rays) & ~(one << king);
+	const Bitmask_t pawns = data.pieces(WHITE_PAWN + offset) & movable;
+	const Bitmask_t knights = data.pieces(WHITE_KNIGHT + offset) & movable;
+	const Bitmask_t orthogonal = (data.pieces(WHITE_ROOK + offset) | data.pieces(WHITE_QUEEN + offset)) & movable;
+	const Bitmask_t diagonal = (data.pieces(WHITE_BISHOP + offset) | data.pieces(WHITE_QUEEN + offset)) & movable;
+
+	targets = move_manager.slider_moves.between(king, checker) | checkers;
+	while (targets) {
+		Coord_t end = pop_lsb(targets);
+		Bitmask_t movers = (move_manager.n_moves.masks[end] & knights)
+			| (move_manager.slider_moves.rook_attacks(end, all_pieces) & orthogonal)
+			| (move_manager.slider_moves.bishop_attacks(end, all_pieces) & diagonal);
+
+		// pawns capture onto the checker and push onto blocking squares
+		Bitmask_t pawn_movers;
+		if (end == checker) {
+			pawn_movers = pawn_attacks<-Us>(one << end) & pawns;
+		}
+		else {
+			const Bitmask_t behind = white ? (one << end) >> 8 : (one << end) << 8;
+			pawn_movers = behind & pawns;
+			if (!pawn_movers && (fourth_rank & (one << end)) && !(all_pieces & behind))
+				pawn_movers = (white ? behind >> 8 : behind << 8) & pawns;
+		}
+
+		while (movers) output.push_back(Move(pop_lsb(movers), end));
+		while (pawn_movers) {
+			Coord_t start = pop_lsb(pawn_movers);
+			if (last_rank & (one << end)) {
+				for (Piece_t promotion = WHITE_KNIGHT + offset; promotion <= WHITE_QUEEN + offset; promotion++)
+					output.push_back(Move(start, end, promotion));
+			}
+			else {
+				output.push_back(Move(start, end));
+			}
+		}
 	}
-	if (!history[depth].ep.is_null())
-		output.push_back(Move(
-			history[depth].ep.start, history[depth].ep.end, MOVE_EN_PASSANT
-		));
 
-	return output;
+	// en passant can capture a checking pawn
+	generate_en_passant<Us>(output, checkers);
 }
\ No newline at end of file
@@ -15,110 +15,313 @@
 #include "move.h"
 #include "score.h"
 #include "params.h"
+#include "material.h"
+#include "pawntable.h"
+#include "evalcache.h"
 
-class BitboardData {
+// Result of a position for the side to move
+typedef unsigned char GameState_t;
+#define GAME_IN_PROGRESS 0
+#define GAME_CHECKMATE 1
+#define GAME_STALEMATE 2
+// Drawn by repeating a position or by the fifty-move rule
+#define GAME_DRAW 3
+
+// Kinds of moves to generate
+typedef unsigned char MoveGen_t;
+// Captures, en passant and all promotions
+#define GEN_CAPTURES 0x01
+// All other moves, including castling
+#define GEN_QUIETS 0x02
+#define GEN_ALL 0x03
+
+// State of the board for one ply. Make writes a new one for every move, so it
+// is kept to two cache lines: everything that can be found from the rest is left out.
+class alignas(64) BitboardData {
 protected:
 	friend class Bitboard;
+	// Zobrist keys, the same in every run so that hashes can be stored and
+	// shared. The hash of a position is the XOR of the keys of each piece on
+	// its square (NO_PIECE has no key), the castling options, the file of the
+	// en passant square if a pawn can capture, and the side if white is to move.
 	static Hash_t zobrist_keys[13][64];
-	static void init_zobrist();
-	static bool is_zobrist_inited;
+	// Keys for each set of castling options (the XOR of the key of each option)
+	static Hash_t zobrist_castling[16];
+	static Hash_t zobrist_ep[8];
+	static Hash_t zobrist_side;
+	static bool init_zobrist();
 
 public:
-	// Current positions of white and black pieces and white and black pawns.
-	Bitmask_t white, black, wpawns, bpawns;
-	// Current positions of all pieces represented as bitmasks
-	Bitmask_t pieces[13];
-	// Color to move.
-	Color_t color;
-	// If an en passant can happen, the start and end coordinates.
-	// No en passant is indicated with a null move
-	BitboardMove ep;
-	// The options for castling kingside/queenside for white and black.
-	// No castling privileges is indicated with 0
-	Castling_t castling;
-	// The move to get to the next dataset
-	BitboardMove move1, move2;
+	// Current positions of white and black pieces.
+	Bitmask_t white, black;
+	// Current positions of each kind of piece of both colours,
+	// indexed by the code of the white piece less one
+	Bitmask_t types[6];
 	// The hash of the current position.
 	Hash_t hash;
+	// The number of each kind of piece
+	MaterialKey_t material_key;
+#if CACHE_ATTACK_MAPS
+	// Squares attacked by white and black
+	Bitmask_t attacks[2];
+#endif
 	// The sum of the values of all pieces
 	Score_t piece_score;
-	// The sum of the score of the positioning of the pieces
+	// The sum of the piece-square values of all pieces, for the middlegame
+	// and the endgame (see make_score)
 	Score_t positioning_score;
-	// The number of pieces on the board
-	unsigned int n_pieces;
+	// Hash of the pawns alone, for the pawn table: the high halves of their
+	// zobrist keys. 32 bits keep the data within two cache lines.
+	uint32_t pawn_key;
+#if INCREMENTAL_ATTACKS
+	// Size of the piece attack log before the move from this position
+	unsigned int attack_log_size;
+#endif
+	// Color to move.
+	Color_t color;
+	// The options for castling kingside/queenside for white and black.
+	// No castling privileges is indicated with 0
+	Castling_t castling;
+	// If an en passant can happen, the square the pawn passed over
+	// (the pawn is one square further on), otherwise NO_MOVE
+	Coord_t ep;
 	// Position of the kings
 	Coord_t white_king, black_king;
+	// Sum of the PHASE_UNITS of all pieces, PHASE_OPENING at the start.
+	// Promotions can take it higher.
+	unsigned char phase;
+	// Plies since the last capture or pawn move, for the fifty-move rule.
+	// Positions before then cannot come up again, so repetitions are only
+	// looked for within this many plies.
+	uint16_t halfmove;
+#if COPY_MAKE
+	// Piece on each square, copied with the rest so that unmake has nothing to do
+	Piece_t squares[64];
+#else
+	// The move to get to the next dataset
+	BitboardMove move1, move2;
+#endif
 
 	BitboardData() {
-		if (!is_zobrist_inited) {
-			init_zobrist();
-			is_zobrist_inited = true;
-		}
+		// initialized exactly once, even if boards are created on several threads
+		static const bool is_zobrist_inited = init_zobrist();
 
 		// zero-initialize everything (since stupid VC++ likes 0xcc)
-		white = black = wpawns = bpawns = 0;
-		color = WHITE;
-		ep = BitboardMove(NO_MOVE, NO_MOVE);
-		castling = 0;
-		move1 = move2 = BitboardMove(NO_MOVE, NO_MOVE);
+		white = black = 0;
+		for (int i = 0; i < 6; i++) types[i] = 0;
 		hash = 0;
+		material_key = 0;
+#if CACHE_ATTACK_MAPS
+		attacks[0] = attacks[1] = 0;
+#endif
 		piece_score = 0;
-		n_pieces = 0;
+		positioning_score = 0;
+		pawn_key = 0;
+#if INCREMENTAL_ATTACKS
+		attack_log_size = 0;
+#endif
+		color = WHITE;
+		castling = 0;
+		ep = NO_MOVE;
 		white_king = black_king = 0;
+		phase = 0;
+		halfmove = 0;
+#if COPY_MAKE
+		for (int i = 0; i < 64; i++) squares[i] = NO_PIECE;
+#else
+		move1 = move2 = BitboardMove(NO_MOVE, NO_MOVE);
+#endif
+	}
+
+	// Current positions of a piece (not NO_PIECE)
+	inline Bitmask_t pieces(const Piece_t piece) const {
+		return types[type_index(piece)] & ((piece < BLACK_PAWN) ? white : black);
 	}
+	// Part of the pawn key for a piece on a square (0 for pieces other than pawns)
+	static inline uint32_t pawn_key_of(const Piece_t piece, const Coord_t square) {
+		return (piece == WHITE_PAWN || piece == BLACK_PAWN) ? (uint32_t)(zobrist_keys[piece][square] >> 32) : 0;
+	}
+	// Index into types for a piece. NO_PIECE gives the index of the kings,
+	// so that clearing an empty square from it does nothing.
+	static inline unsigned int type_index(const Piece_t piece) {
+		return (piece + 5) % 6;
+	}
+};
+
+// A position on its own, without the history of how it was reached.
+// Small enough to hand to other threads, queues or caches by value;
+// a Bitboard is made from it to search.
+class Position {
+public:
+	// Piece on each square
+	Piece_t squares[64];
+	// Color to move
+	Color_t color;
+	// The options for castling kingside/queenside for white and black
+	Castling_t castling;
+	// The square a pawn passed over on the last move, or NO_MOVE
+	Coord_t ep;
+	// Plies since the last capture or pawn move
+	uint16_t halfmove;
+
+	// The starting position
+	Position();
+	Position(const Piece_t squares[64], const Color_t color, const Castling_t castling,
+		const Coord_t ep = NO_MOVE, const uint16_t halfmove = 0);
 };
 
+// A position being searched, with the stack of states to unmake back to.
+// This is large, so a search thread should own one and reuse it.
 class Bitboard {
 protected:
+#if !COPY_MAKE
 	// Table to store piece positions
 	Piece_t squares[64];
-	Piece_t DEFAULT_POS[64] = {
-		4,2,3,5,6,3,2,4,
-		1,1,1,1,1,1,1,1,
-		0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,
-		0,0,0,0,0,0,0,0,
-		7,7,7,7,7,7,7,7,
-		10,8,9,11,12,9,8,10 };
+#endif
 	// Move history storage
 	const static unsigned int HISTORY_DEPTH = MAX_SEARCH_DEPTH;
-	BitboardData history[HISTORY_DEPTH], temp;
+	BitboardData history[HISTORY_DEPTH];
 	int depth;
 
-	// Scoring parameters
-	ScoreParams sparams;
+#if INCREMENTAL_ATTACKS
+	// Squares attacked by the piece on each square (0 for empty squares).
+	// Make only recomputes the pieces a move affects, logging the old values
+	// so that unmake can put them back.
+	Bitmask_t piece_attacks[64];
+	struct AttackLogEntry {
+		Bitmask_t attacks;
+		Coord_t square;
+	};
+	const static unsigned int ATTACK_LOG_DEPTH = HISTORY_DEPTH * 32;
+	AttackLogEntry attack_log[ATTACK_LOG_DEPTH];
+	unsigned int attack_log_size;
+#endif
 
-	// Move finding
-	static MoveManager move_manager;
+	// Scoring parameters, shared by all boards
+	static const ScoreParams sparams;
+	// Terms that depend only on material, shared by the boards of a thread
+	static thread_local MaterialTable material_table;
+	// Terms that depend only on pawns, shared by the boards of a thread
+	static thread_local PawnTable pawn_table;
+	// Scores of recent positions, shared by all boards
+	static EvalCache eval_cache;
+
+	// Move finding, shared by all boards and never modified after construction
+	static const MoveManager move_manager;
 
 public:
 	Bitboard();
-	// Create from a 64 byte grid
-	Bitboard(const Piece_t squares[64], const Color_t color, const Castling_t castling);
+	// Create from a 64 byte grid, with the square a pawn passed over on the
+	// last move if it can be captured en passant and the halfmove clock
+	Bitboard(const Piece_t squares[64], const Color_t color, const Castling_t castling,
+		const Coord_t ep_target = NO_MOVE, const uint16_t halfmove = 0);
+	// Start searching from a position
+	Bitboard(const Position & position);
+
+	// Copy of the current position, without the history
+	Position position() const;
 
 	inline Piece_t operator[](const int index) const {
-		return squares[index];
+		return piece_on(index);
 	}
 
 protected:
-	// Make a move to the bitboard.
+	// Piece on a square in the current position
+	inline Piece_t piece_on(const Coord_t square) const {
+#if COPY_MAKE
+		return history[depth].squares[square];
+#else
+		return squares[square];
+#endif
+	}
+
+	// Make a move to the bitboard for the side to move Us.
 	// Returns whether a capture occurred.
 	// Sophisticated version with specification of current/output data.
 	// Pass special move codes to start and parameters to end.
+	template<Color_t Us>
 	bool make(const Coord_t start, const Coord_t end, const Piece_t promotion_piece,
 		const BitboardData & current, BitboardData & next);
 
+#if !COPY_MAKE
 	// Undo the effects of an individual move on the bitboard.
+	// This does not depend on the side that moved.
 	void unmake(const BitboardMove & move);
+#endif
 
-	bool make_normal(const Coord_t start, const Coord_t end);
-	bool make_castling(Castling_t castling);
-	bool make_ep(const Coord_t start, const Coord_t end);
-	bool make_promotion(const Coord_t start, const Coord_t end, const Piece_t promotion_piece);
+	template<Color_t Us> bool make_move(const Move move);
+	template<Color_t Us> bool make_normal(const Coord_t start, const Coord_t end);
+	template<Color_t Us> bool make_castling(Castling_t castling);
+	template<Color_t Us> bool make_ep(const Coord_t start, const Coord_t end);
+	template<Color_t Us> bool make_promotion(const Coord_t start, const Coord_t end, const Piece_t promotion_piece);
 
 	void increment_depth();
 
+#if INCREMENTAL_ATTACKS
+	// Squares attacked by the piece on a square, with sliders blocked by occupancy
+	Bitmask_t compute_piece_attacks(const Coord_t square, const Bitmask_t occupancy) const;
+	// Recompute the pieces on the changed squares and the sliders whose rays
+	// reached them. The rest of the board cannot have changed.
+	void update_piece_attacks(const BitboardData & next, const Bitmask_t changed);
+	// Undo the logged changes back to a size of the log
+	void unmake_piece_attacks(const unsigned int log_size);
+	// Save the attacks of a square before they are changed
+	inline void log_piece_attacks(const Coord_t square) {
+		attack_log[attack_log_size].attacks = piece_attacks[square];
+		attack_log[attack_log_size].square = square;
+		attack_log_size++;
+	}
+#endif
+
+	// Colour-specialised helpers, where Us is the side to move.
+	// Callers branch on the colour once and everything below is constant.
+
+	// Squares attacked by pawns of a colour
+	template<Color_t C>
+	static inline Bitmask_t pawn_attacks(const Bitmask_t pawns) {
+		return (C == WHITE) ? move_manager.wp_moves.attacks(pawns) : move_manager.bp_moves.attacks(pawns);
+	}
+	// Find the pieces of a colour, grouped by how they attack.
+	// Queens are included in both orthogonal and diagonal.
+	template<Color_t By>
+	void side_pieces(Bitmask_t & pawns, Bitmask_t & knights, Bitmask_t & orthogonal,
+		Bitmask_t & diagonal, Coord_t & king) const;
+	// Pieces of a colour that attack a square, with sliders blocked by occupancy
+	template<Color_t By>
+	Bitmask_t attackers(const Coord_t square, const Bitmask_t occupancy) const;
+	// Squares attacked by a colour, with sliders blocked by occupancy
+	template<Color_t By>
+	Bitmask_t attacks(const Bitmask_t occupancy) const;
+	// Squares attacked by a colour in the current position
+	template<Color_t By>
+	Bitmask_t attacked_squares() const;
+	// Fill in the attack maps of the current position when they are cached
+	void update_attacks();
+	// Pieces of the side not to move that attack the king of the side to move
+	template<Color_t Us>
+	Bitmask_t checkers() const;
+	// Pieces of the side to move that are pinned to the king.
+	// Fills in the squares each pinned piece can still move to.
+	template<Color_t Us>
+	Bitmask_t pinned_pieces(Bitmask_t pin_rays[64]) const;
+	// Mobility score of the pieces of a colour, with the sign of that colour,
+	// given the squares attacked by enemy pawns.
+	// This and the pawn scores below are middlegame/endgame pairs (see make_score).
+	template<Color_t Us>
+	Score_t mobility(const Bitmask_t enemy_pawn_attacks) const;
+	// The pawn table entry of the current position, filled in if missing
+	const PawnEntry & pawn_entry() const;
+	// Score of the pawn terms that only depend on pawns
+	Score_t score_pawns_only() const;
+	// Score of pawns blocked by pieces in front of them
+	Score_t score_blocked_pawns() const;
+	template<Color_t Us>
+	void generate_moves(MoveBuffer<MAX_MOVES> & output, const MoveGen_t gen) const;
+	template<Color_t Us>
+	void generate_en_passant(MoveBuffer<MAX_MOVES> & output, const Bitmask_t checkers) const;
+	template<Color_t Us>
+	void generate_evasions(MoveBuffer<MAX_MOVES> & output) const;
+
 public:
 	// Make a move to change the board state
 	bool make(const Move move);
@@ -126,30 +329,97 @@ public:
 	void make(std::vector<Move> & moves);
 	// Go back a certain number of moves
 	void unmake();
+	// Pass the move to the other side: the side to move changes and
+	// en passant is lost, but no pieces move. Illegal when in check.
+	// make also does this for a null Move.
+	void make_null();
+	// Take back a null move (unmake also does this)
+	void unmake_null();
 
-	// Get a list of moves available in the position
-	// The moves are guaranteed to be sorted according to start then end
+	// Get a list of legal moves available in the position
+	// The moves are guaranteed to be sorted according to start then end,
+	// followed by castling and en passant
 	std::vector<Move> get_moves() const;
+	// Append the legal moves of the requested kinds to the output,
+	// in the same order as above, without allocating
+	void get_moves(MoveBuffer<MAX_MOVES> & output, const MoveGen_t gen = GEN_ALL) const;
+
+	// Legal captures, en passant and promotions only, for tactical search.
+	// The moves are in the same order as get_moves.
+	void generate_captures(MoveBuffer<MAX_MOVES> & output) const;
+	// Legal moves out of check: king moves, then moves that capture or block
+	// the checker. Generates nothing if the side to move is not in check.
+	void generate_evasions(MoveBuffer<MAX_MOVES> & output) const;
+
+	// Pieces of both colours that attack a square, with sliders blocked by occupancy
+	Bitmask_t attackers_to(const Coord_t square, const Bitmask_t occupancy) const;
+	// Whether a colour attacks a square in the current position
+	bool is_square_attacked(const Coord_t square, const Color_t by) const;
+	// Squares attacked by a colour in the current position.
+	// Kept for every ply in make when CACHE_ATTACK_MAPS is set.
+	Bitmask_t attacked_squares(const Color_t by) const;
+	// Static exchange evaluation: the material the side to move wins with a
+	// capture if both sides keep recapturing on the square with their least
+	// valuable piece, each stopping when it is better to
+	Score_t see(const Move move) const;
+
+	// Whether the king of the side to move is attacked
+	bool in_check() const;
+	// Whether a colour has any pieces other than pawns and the king
+	bool has_pieces(const Color_t color) const;
+	// Whether the game is over by checkmate, stalemate, repetition or the
+	// fifty-move rule
+	GameState_t game_state() const;
+	// Whether the position is drawn by the fifty-move rule or repeats a
+	// position since the board was created. Only positions with the same side
+	// to move since the last capture or pawn move are compared.
+	// A single repetition counts, since the search could repeat it again.
+	bool is_draw() const;
 
 	// Access to read-only current board state
 	inline const BitboardData & current_data() const {
 		return history[depth];
 	}
+	// Number of moves made since the bitboard was created
+	inline int ply() const {
+		return depth;
+	}
 
 	// Get the score of the material on the board
 	Score_t score_material() const;
 	// Get the score of the pawn structure
 	Score_t score_pawn_structure() const;
-	// Get the score of the mobility/position of the pieces
+	// Pawn table of this thread, for its hit rate
+	static inline PawnTable & get_pawn_table() {
+		return pawn_table;
+	}
+	// Evaluation cache, for its counts of hits and misses
+	static inline EvalCache & get_eval_cache() {
+		return eval_cache;
+	}
+	// Calls to score_lazy on this thread, and how many of them returned the
+	// material alone
+	static thread_local unsigned long long lazy_evaluations, lazy_cutoffs;
+	// Get the score of the mobility of the pieces
 	Score_t score_piece_position() const;
 	// Get the king safety score
 	Score_t score_king_safety() const;
+	// Get the score for driving a bare king to the edge and bringing the
+	// other king close, for the side with the material
+	Score_t score_kxk(const Color_t strong_side) const;
 
 	typedef Score_t(Bitboard::*ScoreFunction)() const;
 	// Softest scoring setting based only on material
 	Score_t score_level_0() const;
-	// Next hardest scoring setting to determine rough score for end nodes
+	// Next hardest scoring setting to determine rough score for end nodes.
+	// Looks in the evaluation cache first.
 	Score_t score_level_1() const;
+	// The same as score_level_1 without the evaluation cache
+	Score_t evaluate() const;
+	// score_level_1 for a leaf searched with a window from white's point of
+	// view. When the material is more than LAZY_EVAL_MARGIN outside the window,
+	// the full score cannot be inside it and the material is returned instead.
+	Score_t score_lazy(const Score_t alpha, const Score_t beta) const;
 
 	typedef Move_Rank_t(Bitboard::*MoveRankFunction)(const Move);
 	// Get a ranking for likely best move before exploring
@@ -23,9 +23,9 @@
 #define V_MOVE_TABLE_DEBUG 0
 #define D1_MOVE_TABLE_DEBUG 0
 #define D2_MOVE_TABLE_DEBUG 0
-#define N_MOVE_TABLE_DEBUG 0
-#define K_MOVE_TABLE_DEBUG 0
-#define WP_MOVE_TABLE_DEBUG 0
-#define BP_MOVE_TABLE_DEBUG 0
+#define SLIDER_MOVE_TABLE_DEBUG 0
+
+// Count heap allocations for the benchmarks in test.h
+#define COUNT_ALLOCATIONS 1
 
 #endif
\ No newline at end of file
@@ -18,10 +18,27 @@
 #include "search.h"
 #include "test.h"
 #include "fen.h"
+#include "perft.h"
+
+#include <cstdlib>
+#include <string>
 
 const char * kasparov_1 = "1rb2rk1/1pqn1p1p/2pN2p1/p1N2P2/Pn1QP3/1P5P/4B1P1/2R2RK1 w - - 1 27";
 
-int main() {
+int main(int argc, char * argv[]) {
+	// "perft <depth> [fen]" to divide a position (the starting position by default),
+	// or "perft bench" for the reference positions
+	if (argc >= 3 && std::string(argv[1]) == "perft") {
+		if (std::string(argv[2]) == "bench") return perft_benchmark(std::cout) ? 0 : 1;
+		std::string fen;
+		for (int i = 3; i < argc; i++) {
+			if (i > 3) fen += ' ';
+			fen += argv[i];
+		}
+		perft_divide(fen.empty() ? Position() : parse_fen(fen), std::atoi(argv[2]), std::cout);
+		return 0;
+	}
+
 	/*
 	bitboard.make(Move(12, 28));	//e4
 	bitboard.make(Move(52, 36));	//e5
@@ -46,8 +63,7 @@ int main() {
 	n.print_tree();
 	*/
 
-	Bitboard bitboard = parse_fen(kasparov_1);
-	GameTree gt = GameTree(bitboard);
+	GameTree gt(parse_fen(kasparov_1));
 	std::cout << "Starting tree generation\n";
 
 	std::chrono::time_point<std::chrono::system_clock> start, end;
@@ -61,6 +77,9 @@ int main() {
 	std::chrono::duration<double> dur = end - start;
 	std::cout << "Test elapsed in " << dur.count() << " seconds\n";
 	std::cout << "Searched " << Node::searched_nodes << " nodes\n";
+	std::cout << "Pawn table hit rate " << Bitboard::get_pawn_table().hit_rate() * 100 << "%\n";
+	std::cout << "Evaluation cache " << Bitboard::get_eval_cache().get_hits() << " hits, "
+		<< Bitboard::get_eval_cache().get_misses() << " misses\n";
 
 	gt.print_tree(2, { "d6-c8" });
 
@@ -0,0 +1,36 @@
+/*******************************************************************************
+* Deep Winkelman
+*
+* Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
+* 16 June 2017
+*
+* Implementation of the evaluation cache
+*/
+
+#include "evalcache.h"
+
+EvalCache::EvalCache(const unsigned int bits) {
+	if (bits == 0) {
+		entries = nullptr;
+		mask = 0;
+	}
+	else {
+		mask = (one << bits) - 1;
+		entries = new std::atomic<uint64_t>[mask + 1];
+	}
+	clear();
+}
+
+EvalCache::~EvalCache() {
+	delete[] entries;
+}
+
+void EvalCache::clear() {
+	// an empty entry could only be mistaken for a position whose hash has an
+	// upper half of 0, as likely as any other collision
+	for (uint64_t i = 0; entries && i <= mask; i++) {
+		entries[i].store(0, std::memory_order_relaxed);
+	}
+	hits.store(0, std::memory_order_relaxed);
+	misses.store(0, std::memory_order_relaxed);
+}
\ No newline at end of file
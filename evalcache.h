@@ -0,0 +1,73 @@
+/*******************************************************************************
+* Deep Winkelman
+*
+* Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
+* 16 June 2017
+*
+* Cache of evaluations, keyed by the hash of the position.
+*
+* The same position is evaluated by populate, by move ranking and again when
+* it is reached by another move order. Each entry is one 64-bit word holding
+* the upper half of the hash and the score, so threads can read and write it
+* without locks: a word is never seen half written, and a different position
+* in the same slot fails the check. New scores always replace old ones.
+*/
+
+#ifndef DEEP_WINKELMAN_EVALCACHE
+#define DEEP_WINKELMAN_EVALCACHE
+
+#include <atomic>
+
+#include "move.h"
+#include "score.h"
+
+class EvalCache {
+protected:
+	std::atomic<uint64_t> * entries;
+	uint64_t mask;
+
+	// Counted with a plain load and store instead of a locked add, which would
+	// cost more than the probe. Threads racing can lose a few counts.
+	std::atomic<unsigned long long> hits, misses;
+	static inline void count(std::atomic<unsigned long long> & counter) {
+		counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+public:
+	// Create with 2^bits entries, up to 2^32 (0 for no cache)
+	EvalCache(const unsigned int bits);
+	~EvalCache();
+	EvalCache(const EvalCache &) = delete;
+	EvalCache & operator =(const EvalCache &) = delete;
+
+	// Whether the score of a position is in the cache, and if so what it is
+	inline bool probe(const Hash_t hash, Score_t & score) {
+		if (!entries) return false;
+		const uint64_t entry = entries[hash & mask].load(std::memory_order_relaxed);
+		if ((entry ^ hash) >> 32) {
+			count(misses);
+			return false;
+		}
+		count(hits);
+		score = (Score_t)(uint32_t)entry;
+		return true;
+	}
+
+	inline void store(const Hash_t hash, const Score_t score) {
+		if (!entries) return;
+		entries[hash & mask].store((hash & 0xffffffff00000000ULL) | (uint32_t)score,
+			std::memory_order_relaxed);
+	}
+
+	// Forget all scores and counts
+	void clear();
+
+	inline unsigned long long get_hits() const {
+		return hits.load(std::memory_order_relaxed);
+	}
+	inline unsigned long long get_misses() const {
+		return misses.load(std::memory_order_relaxed);
+	}
+};
+
+#endif
\ No newline at end of file
@@ -4,7 +4,7 @@
 * Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
 * 18 May 2017
 *
-* Parsing of Forsyth-Edwards Notation (FEN) strings into bitboards
+* Parsing of Forsyth-Edwards Notation (FEN) strings into positions
 */
 
 #ifndef DEEP_WINKELMAN_FEN
@@ -12,7 +12,7 @@
 
 #include "bitboard.h"
 
-Bitboard parse_fen(std::string fen) {
+inline Position parse_fen(std::string fen) {
 	Piece_t board[64];
 
 	std::string::iterator it, end;
@@ -55,16 +55,37 @@ Bitboard parse_fen(std::string fen) {
 	// get color to move
 	Color_t color_to_move = *it == 'w' ? WHITE : BLACK;
 	++it;
+	++it;
+
+	// get castling ("-" if none)
+	Castling_t castling = 0;
+	while (it != end && *it != ' ') {
+		switch (*it) {
+		case 'K': castling |= WHITE_OO;		break;
+		case 'Q': castling |= WHITE_OOO;	break;
+		case 'k': castling |= BLACK_OO;		break;
+		case 'q': castling |= BLACK_OOO;	break;
+		}
+		++it;
+	}
+
+	// get en passant target square ("-" if none)
+	Coord_t ep_target = NO_MOVE;
+	if (it != end) ++it;
+	if (it != end && 'a' <= *it && *it <= 'h' && it + 1 != end) {
+		ep_target = (*(it + 1) - '1') * 8 + (*it - 'a');
+	}
+	while (it != end && *it != ' ') ++it;
 
-	// get castling
-	Castling_t castling =
-		(*(it++) == 'K') ? WHITE_OO : 0 |
-		(*(it++) == 'Q') ? WHITE_OOO : 0 |
-		(*(it++) == 'k') ? BLACK_OO : 0 |
-		(*(it++) == 'q') ? BLACK_OOO : 0;
+	// get halfmove clock (0 if missing)
+	uint16_t halfmove = 0;
+	if (it != end) ++it;
+	for (; it != end && '0' <= *it && *it <= '9'; ++it) {
+		halfmove = halfmove * 10 + (*it - '0');
+		if (halfmove > 100) halfmove = 100;
+	}
 
-	Bitboard output(board, color_to_move, castling);
-	return output;
+	return Position(board, color_to_move, castling, ep_target, halfmove);
 }
 
 #endif
\ No newline at end of file
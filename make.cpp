@@ -10,15 +10,39 @@
 #include "bitboard.h"
 #include "errors.h"
 
-// Promotion piece must be the same as end piece if no promotion happens.
+// Castling options kept when a piece moves from or to each square
+static const Castling_t CASTLING_KEPT[64] = {
+	15 & ~WHITE_OOO, 15, 15, 15, 15 & ~(WHITE_OO | WHITE_OOO), 15, 15, 15 & ~WHITE_OO,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15 & ~BLACK_OOO, 15, 15, 15, 15 & ~(BLACK_OO | BLACK_OOO), 15, 15, 15 & ~BLACK_OO
+};
+
+// Promotion piece must be the same as start piece if no promotion happens.
+// The current and next data can be the same, for the second half of castling
+// and en passant, so each field is read before it is written.
+template<Color_t Us>
 bool Bitboard::make(const Coord_t start, const Coord_t end, const Piece_t promotion_piece,
 	const BitboardData & current, BitboardData & next) {
-	static Piece_t start_piece, end_piece;
-	start_piece = squares[start], end_piece = squares[end];
+	const Piece_t pawn = (Us == WHITE) ? WHITE_PAWN : BLACK_PAWN;
+	const int up = (Us == WHITE) ? 8 : -8;
+
+#if COPY_MAKE
+	// build the next data in one pass from a copy, mailbox included
+	if (&next != &current) next = current;
+	Piece_t * const board = next.squares;
+#else
+	Piece_t * const board = squares;
+#endif
+	const Piece_t start_piece = board[start], end_piece = board[end];
 
 	// adjust board squares
-	squares[start] = NO_PIECE;
-	squares[end] = promotion_piece;
+	board[start] = NO_PIECE;
+	board[end] = promotion_piece;
 
 	// increment piece score
 	next.piece_score = current.piece_score - sparams.PIECE_VALUES[end_piece];
@@ -26,93 +50,102 @@ bool Bitboard::make(const Coord_t start, const Coord_t end, const Piece_t promot
 		next.piece_score += sparams.PIECE_VALUES[promotion_piece]
 		- sparams.PIECE_VALUES[start_piece];
 
-	// update number of pieces on the board
-	if (end_piece == NO_PIECE) next.n_pieces = current.n_pieces;
-	else next.n_pieces = current.n_pieces - 1;
+	// increment piece-square score
+	// remove start piece * remove end piece * add start piece at end
+	next.positioning_score = current.positioning_score
+		- sparams.PIECE_SQUARES[start_piece][start]
+		- sparams.PIECE_SQUARES[end_piece][end]
+		+ sparams.PIECE_SQUARES[promotion_piece][end];
+
+	// increment material key (only changes on captures and promotions)
+	next.material_key = current.material_key
+		- MATERIAL_UNITS[start_piece]
+		- MATERIAL_UNITS[end_piece]
+		+ MATERIAL_UNITS[promotion_piece];
+
+	// increment game phase, which changes in the same places
+	next.phase = current.phase
+		- PHASE_UNITS[start_piece]
+		- PHASE_UNITS[end_piece]
+		+ PHASE_UNITS[promotion_piece];
 
 	// update the positions of the white and black kings
-	if (start_piece == WHITE_KING) next.white_king = end;
-	else next.white_king = current.white_king;
-	if (start_piece == BLACK_KING) next.black_king = end;
-	else next.black_king = current.black_king;
+	next.white_king = (start_piece == WHITE_KING) ? end : current.white_king;
+	next.black_king = (start_piece == BLACK_KING) ? end : current.black_king;
 
 	// increment hash
-	// remove start piece * add empty at start * remove end piece * add start piece at end
+	// remove start piece * remove end piece * add start piece at end
 	next.hash = current.hash
 		^ BitboardData::zobrist_keys[start_piece][start]
-		^ BitboardData::zobrist_keys[NO_PIECE][start]
 		^ BitboardData::zobrist_keys[end_piece][end]
-		^ BitboardData::zobrist_keys[start_piece][end];
+		^ BitboardData::zobrist_keys[promotion_piece][end];
+
+	// increment pawn key
+	next.pawn_key = current.pawn_key
+		^ BitboardData::pawn_key_of(start_piece, start)
+		^ BitboardData::pawn_key_of(end_piece, end)
+		^ BitboardData::pawn_key_of(promotion_piece, end);
 
 	// increment bitboards
-	if (current.color == WHITE) {
+	if (Us == WHITE) {
 		next.white = (current.white & ~(one << start)) | (one << end);
 		next.black = current.black & ~(one << end);
-		next.wpawns = next.white & current.wpawns;
-		next.bpawns = next.black & current.bpawns;
-		// add the pawn to the end square only if it did not promote
-		if (start_piece == WHITE_PAWN && start_piece == promotion_piece)
-			next.wpawns |= one << end;
 	}
 	else {
 		next.white = current.white & ~(one << end);
 		next.black = (current.black & ~(one << start)) | (one << end);
-		next.wpawns = next.white & current.wpawns;
-		next.bpawns = next.black & current.bpawns;
-		// add the pawn to the end square only if it did not promote
-		if (start_piece == BLACK_PAWN && start_piece == promotion_piece)
-			next.bpawns |= one << end;
 	}
 
-	// increment piece bitboards
-	
+	// increment piece bitboards; unmaking goes back to the previous entry
+	// in the history, so nothing has to be undone
+#if !COPY_MAKE
+	for (int i = 0; i < 6; i++) next.types[i] = current.types[i];
+#endif
+	next.types[BitboardData::type_index(start_piece)] &= ~(one << start);
+	next.types[BitboardData::type_index(end_piece)] &= ~(one << end);
+	next.types[BitboardData::type_index(promotion_piece)] |= one << end;
 
-	// update castling
-	next.castling = current.castling;
-	if (start_piece == WHITE_KING) next.castling &= ~(WHITE_OO | WHITE_OOO);
-	else if (start_piece == WHITE_ROOK) {
-		if (squares[0] != WHITE_ROOK) next.castling &= ~WHITE_OOO;
-		if (squares[7] != WHITE_ROOK) next.castling &= ~WHITE_OO;
-	}
-	else if (start_piece == BLACK_KING) next.castling &= ~(BLACK_OO | BLACK_OOO);
-	else if (start_piece == BLACK_ROOK) {
-		if (squares[56] != BLACK_ROOK)next.castling &= ~BLACK_OOO;
-		if (squares[63] != BLACK_ROOK)next.castling &= ~BLACK_OO;
-	}
+	// update castling (moving the king or a rook, or capturing a rook)
+	const Castling_t castling = current.castling & CASTLING_KEPT[start] & CASTLING_KEPT[end];
+	next.hash ^= BitboardData::zobrist_castling[current.castling] ^ BitboardData::zobrist_castling[castling];
+	next.castling = castling;
+
+	// reset the halfmove clock on a capture or pawn move. The rook half of
+	// castling makes in place, so make_castling counts its ply itself.
+	next.halfmove = (start_piece == pawn || end_piece != NO_PIECE) ? 0 : current.halfmove + 1;
 
 	// update en passant
-	next.ep = BitboardMove(NO_MOVE, NO_MOVE);
 	// Need the pawn to move up two squares, have an enemy pawn on the left or right
-	if (start_piece == WHITE_PAWN && end - start == 16) {
-		if (start > 24 && start < 32 && squares[end - 1] == BLACK_PAWN) {
-			next.ep = BitboardMove(end - 1, end);
-		}
-		else if (start > 23 && start < 31 && squares[end + 1] == BLACK_PAWN) {
-			next.ep = BitboardMove(end + 1, end);
-		}
-	}
-	else if (start_piece == BLACK_PAWN && start - end == 16) {
-		if (start > 32 && start < 40 && squares[end - 1] == WHITE_PAWN) {
-			next.ep = BitboardMove(end - 1, end);
-		}
-		else if (start > 31 && start < 39 && squares[end + 1] == WHITE_PAWN) {
-			next.ep = BitboardMove(end + 1, end);
+	if (current.ep != NO_MOVE) next.hash ^= BitboardData::zobrist_ep[current.ep % 8];
+	next.ep = NO_MOVE;
+	if (start_piece == pawn && end == start + 2 * up) {
+		if (pawn_attacks<Us>(one << (start + up)) & next.pieces((Us == WHITE) ? BLACK_PAWN : WHITE_PAWN)) {
+			next.ep = start + up;
+			next.hash ^= BitboardData::zobrist_ep[next.ep % 8];
 		}
 	}
 
+#if INCREMENTAL_ATTACKS
+	update_piece_attacks(next, (one << start) | (one << end));
+#endif
+
 	return end_piece != NO_PIECE;
 }
 
+template<Color_t Us>
 bool Bitboard::make_normal(const Coord_t start, const Coord_t end) {
 	// write to history, then make the move
+#if !COPY_MAKE
 	history[depth].move1 = BitboardMove(start, end, squares[start], squares[end]);
+	history[depth].move2 = BitboardMove(NO_MOVE, NO_MOVE);
+#endif
 
 	// make the move
-	static bool capture;
-	capture = make(start, end, squares[start], history[depth], history[depth + 1]);
+	bool capture = make<Us>(start, end, piece_on(start), history[depth], history[depth + 1]);
 
 	// increment color
-	history[depth + 1].color = (history[depth].color == WHITE) ? BLACK : WHITE;
+	history[depth + 1].color = -Us;
+	history[depth + 1].hash ^= BitboardData::zobrist_side;
 
 	// increment depth
 	increment_depth();
@@ -121,9 +154,10 @@ bool Bitboard::make_normal(const Coord_t start, const Coord_t end) {
 }
 
 // Does not double check move clearance or check status of each square
+template<Color_t Us>
 bool Bitboard::make_castling(Castling_t castling) {
 	// determine coords for making the move
-	static Coord_t k_start, k_end, r_start, r_end;
+	Coord_t k_start, k_end, r_start, r_end;
 	switch (castling) {
 	case WHITE_OO:
 		k_start = 4, k_end = 6;
@@ -138,21 +172,28 @@ bool Bitboard::make_castling(Castling_t castling) {
 		r_start = 63, r_end = 61;
 		break;
 	case BLACK_OOO:
+	default:
 		k_start = 60, k_end = 58;
 		r_start = 56, r_end = 59;
 		break;
 	}
 
 	// write to history
+#if !COPY_MAKE
 	history[depth].move1 = BitboardMove(k_start, k_end, squares[k_start], squares[k_end]);
 	history[depth].move2 = BitboardMove(r_start, r_end, squares[r_start], squares[r_end]);
+#endif
 
-	// make the move
-	make(k_start, k_end, squares[k_start], history[depth], temp);
-	make(r_start, r_end, squares[r_start], temp, history[depth + 1]);
+	// move the king, then move the rook in place on the new data
+	const Piece_t king = (Us == WHITE) ? WHITE_KING : BLACK_KING;
+	const Piece_t rook = (Us == WHITE) ? WHITE_ROOK : BLACK_ROOK;
+	make<Us>(k_start, k_end, king, history[depth], history[depth + 1]);
+	make<Us>(r_start, r_end, rook, history[depth + 1], history[depth + 1]);
+	history[depth + 1].halfmove = history[depth].halfmove + 1;
 
 	// increment color
-	history[depth + 1].color = (history[depth].color == WHITE) ? BLACK : WHITE;
+	history[depth + 1].color = -Us;
+	history[depth + 1].hash ^= BitboardData::zobrist_side;
 
 	// increment depth
 	increment_depth();
@@ -160,28 +201,26 @@ bool Bitboard::make_castling(Castling_t castling) {
 	return false;
 }
 
+template<Color_t Us>
 bool Bitboard::make_ep(const Coord_t start, const Coord_t end) {
-	if (history[depth].color == WHITE) {
-		// write to history
-		history[depth].move1 = BitboardMove(start, end - 8, squares[start], squares[end - 8]);
-		history[depth].move2 = BitboardMove(end - 8, end, squares[end - 8], squares[end]);
-
-		// make the move
-		make(start, end - 8, squares[start], history[depth], temp);
-		make(end - 8, end, squares[end - 8], temp, history[depth + 1]);
-	}
-	else {
-		// write to history
-		history[depth].move1 = BitboardMove(start, end + 8, squares[start], squares[end + 8]);
-		history[depth].move2 = BitboardMove(end + 8, end, squares[end + 8], squares[end]);
+	// the pawn first captures sideways, then moves up to the target square
+	const int up = (Us == WHITE) ? 8 : -8;
+	const Coord_t captured = end - up;
 
-		// make the move
-		make(start, end + 8, squares[start], history[depth], temp);
-		make(end + 8, end, squares[end + 8], temp, history[depth + 1]);
-	}
+	// write to history
+#if !COPY_MAKE
+	history[depth].move1 = BitboardMove(start, captured, squares[start], squares[captured]);
+	history[depth].move2 = BitboardMove(captured, end, squares[captured], squares[end]);
+#endif
+
+	// capture, then move up in place on the new data
+	const Piece_t pawn = (Us == WHITE) ? WHITE_PAWN : BLACK_PAWN;
+	make<Us>(start, captured, pawn, history[depth], history[depth + 1]);
+	make<Us>(captured, end, pawn, history[depth + 1], history[depth + 1]);
 
 	// increment color
-	history[depth + 1].color = (history[depth].color == WHITE) ? BLACK : WHITE;
+	history[depth + 1].color = -Us;
+	history[depth + 1].hash ^= BitboardData::zobrist_side;
 
 	// increment depth
 	increment_depth();
@@ -189,16 +228,20 @@ bool Bitboard::make_ep(const Coord_t start, const Coord_t end) {
 	return true;
 }
 
+template<Color_t Us>
 bool Bitboard::make_promotion(const Coord_t start, const Coord_t end, const Piece_t promotion_piece) {
 	// write to history, then make the move
+#if !COPY_MAKE
 	history[depth].move1 = BitboardMove(start, end, squares[start], squares[end], promotion_piece);
+	history[depth].move2 = BitboardMove(NO_MOVE, NO_MOVE);
+#endif
 
 	// make the move
-	static bool capture;
-	capture = make(start, end, squares[start], history[depth], history[depth + 1]);
+	bool capture = make<Us>(start, end, promotion_piece, history[depth], history[depth + 1]);
 
 	// increment color
-	history[depth + 1].color = (history[depth].color == WHITE) ? BLACK : WHITE;
+	history[depth + 1].color = -Us;
+	history[depth + 1].hash ^= BitboardData::zobrist_side;
 
 	// increment depth
 	increment_depth();
@@ -206,23 +249,69 @@ bool Bitboard::make_promotion(const Coord_t start, const Coord_t end, const Piec
 	return capture;
 }
 
-bool Bitboard::make(const Move move) {
-	static bool capture;
+template<Color_t Us>
+bool Bitboard::make_move(const Move move) {
+#if INCREMENTAL_ATTACKS
+	history[depth].attack_log_size = attack_log_size;
+#endif
+
+	bool capture = false;
 	if (move.is_normal()) {
-		capture = make_normal(move.start(), move.end());
+		capture = make_normal<Us>(move.start(), move.end());
 	}
 	else if (move.is_castling()) {
-		capture = make_castling(move.castling_type());
+		capture = make_castling<Us>(move.castling_type());
 	}
 	else if (move.is_en_passant()) {
-		capture = make_ep(move.start(), move.end());
+		capture = make_ep<Us>(move.start(), move.end());
 	}
 	else if (move.is_promotion()) {
-		capture = make_promotion(move.start(), move.end(), move.promotion_piece());
+		capture = make_promotion<Us>(move.start(), move.end(), move.promotion_piece());
+	}
+	else if (move.is_null()) {
+		make_null();
 	}
 	return capture;
 }
 
+void Bitboard::make_null() {
+	BitboardData & current = history[depth];
+	if (depth + 1 >= HISTORY_DEPTH)
+		throw new DeepWinkelmanException(
+			"Bitboard cannot move beyond maximum history depth."
+		);
+#if !COPY_MAKE
+	// there are no squares for unmake to put back
+	current.move1 = current.move2 = BitboardMove(NO_MOVE, NO_MOVE);
+#endif
+#if INCREMENTAL_ATTACKS
+	current.attack_log_size = attack_log_size;
+#endif
+
+	// the pieces and their attacks stay the same
+	BitboardData & next = history[depth + 1];
+	next = current;
+	next.color = -current.color;
+	next.hash ^= BitboardData::zobrist_side;
+	if (current.ep != NO_MOVE) {
+		next.hash ^= BitboardData::zobrist_ep[current.ep % 8];
+		next.ep = NO_MOVE;
+	}
+	// positions from before the pass are not repetitions in the search
+	next.halfmove = 0;
+	depth++;
+}
+
+void Bitboard::unmake_null() {
+	depth--;
+	if (depth < 0) depth = 0;
+}
+
+bool Bitboard::make(const Move move) {
+	if (history[depth].color == WHITE) return make_move<WHITE>(move);
+	else return make_move<BLACK>(move);
+}
+
 void Bitboard::make(std::vector<Move>& moves)
 {
 	std::vector<Move>::iterator it, end;
@@ -231,26 +320,98 @@ void Bitboard::make(std::vector<Move>& moves)
 	}
 }
 
+#if !COPY_MAKE
 void Bitboard::unmake(const BitboardMove & move) {
 	squares[move.start] = move.start_piece;
 	squares[move.end] = move.end_piece;
 }
+#endif
 
 void Bitboard::unmake() {
 	// go back in history one level
 	depth--;
 	if (depth < 0) depth = 0;
 
-	// change the squares
+#if !COPY_MAKE
+	// change the squares (there are none after a null move)
 	if (!history[depth].move2.is_null())
 		unmake(history[depth].move2);
-	unmake(history[depth].move1);
+	if (!history[depth].move1.is_null())
+		unmake(history[depth].move1);
+#endif
+
+#if INCREMENTAL_ATTACKS
+	unmake_piece_attacks(history[depth].attack_log_size);
+#endif
 }
 
+#if INCREMENTAL_ATTACKS
+Bitmask_t Bitboard::compute_piece_attacks(const Coord_t square, const Bitmask_t occupancy) const {
+	switch (piece_on(square)) {
+	case WHITE_PAWN: return pawn_attacks<WHITE>(one << square);
+	case BLACK_PAWN: return pawn_attacks<BLACK>(one << square);
+	case WHITE_KNIGHT: case BLACK_KNIGHT: return move_manager.n_moves.masks[square];
+	case WHITE_BISHOP: case BLACK_BISHOP: return move_manager.slider_moves.bishop_attacks(square, occupancy);
+	case WHITE_ROOK: case BLACK_ROOK: return move_manager.slider_moves.rook_attacks(square, occupancy);
+	case WHITE_QUEEN: case BLACK_QUEEN: return move_manager.slider_moves.queen_attacks(square, occupancy);
+	case WHITE_KING: case BLACK_KING: return move_manager.k_moves.masks[square];
+	default: return 0;
+	}
+}
+
+void Bitboard::update_piece_attacks(const BitboardData & next, const Bitmask_t changed) {
+	const Bitmask_t occupancy = next.white | next.black;
+	if (attack_log_size + 64 > ATTACK_LOG_DEPTH)
+		throw new DeepWinkelmanException(
+			"Bitboard cannot log more piece attack changes."
+		);
+
+	// the pieces on the changed squares (or the lack of them)
+	for (Bitmask_t squares_left = changed; squares_left; ) {
+		Coord_t i = pop_lsb(squares_left);
+		log_piece_attacks(i);
+		piece_attacks[i] = compute_piece_attacks(i, occupancy);
+	}
+
+	// A slider only sees a different board if one of the changed squares was
+	// on its rays, up to and including the first blocker
+	const Bitmask_t queens = next.pieces(WHITE_QUEEN) | next.pieces(BLACK_QUEEN);
+	Bitmask_t diagonal = (next.pieces(WHITE_BISHOP) | next.pieces(BLACK_BISHOP) | queens) & ~changed;
+	Bitmask_t orthogonal = (next.pieces(WHITE_ROOK) | next.pieces(BLACK_ROOK) | queens) & ~changed;
+	while (diagonal) {
+		Coord_t i = pop_lsb(diagonal);
+		if (piece_attacks[i] & changed) {
+			log_piece_attacks(i);
+			piece_attacks[i] = move_manager.slider_moves.bishop_attacks(i, occupancy) |
+				((queens >> i) & 1 ? move_manager.slider_moves.rook_attacks(i, occupancy) : 0);
+			orthogonal &= ~(one << i);
+		}
+	}
+	while (orthogonal) {
+		Coord_t i = pop_lsb(orthogonal);
+		if (piece_attacks[i] & changed) {
+			log_piece_attacks(i);
+			piece_attacks[i] = move_manager.slider_moves.rook_attacks(i, occupancy) |
+				((queens >> i) & 1 ? move_manager.slider_moves.bishop_attacks(i, occupancy) : 0);
+		}
+	}
+}
+
+void Bitboard::unmake_piece_attacks(const unsigned int log_size) {
+	while (attack_log_size > log_size) {
+		attack_log_size--;
+		piece_attacks[attack_log[attack_log_size].square] = attack_log[attack_log_size].attacks;
+	}
+}
+#endif
+
 void Bitboard::increment_depth() {
 	depth++;
 	if (depth >= HISTORY_DEPTH)
 		throw new DeepWinkelmanException(
 			"Bitboard cannot move beyond maximum history depth."
 		);
+
+	// every way of making a move ends here with the new position complete
+	update_attacks();
 }
\ No newline at end of file
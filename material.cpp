@@ -0,0 +1,77 @@
+/*******************************************************************************
+* Deep Winkelman
+*
+* Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
+* 14 June 2017
+*
+* Implementation of the material table
+*/
+
+#include "material.h"
+
+const MaterialKey_t MATERIAL_UNITS[13] = {
+	0,
+	1ULL << 0, 1ULL << 4, 1ULL << 8, 1ULL << 12, 1ULL << 16, 0,
+	1ULL << 20, 1ULL << 24, 1ULL << 28, 1ULL << 32, 1ULL << 36, 0
+};
+
+const unsigned char PHASE_UNITS[13] = {
+	0,
+	0, 1, 1, 2, 4, 0,
+	0, 1, 1, 2, 4, 0
+};
+
+MaterialTable::MaterialTable() {
+	// no position has every count at 15, so every first probe misses
+	for (unsigned int i = 0; i < SIZE; i++) {
+		entries[i].key = ~(MaterialKey_t)0;
+	}
+}
+
+MaterialEntry MaterialTable::compute(const MaterialKey_t key, const ScoreParams & sparams) {
+	MaterialEntry entry;
+	entry.key = key;
+	entry.imbalance = 0;
+	entry.endgame = ENDGAME_NONE;
+	entry.strong_side = WHITE;
+
+	unsigned int pawns[2], knights[2], bishops[2], rooks[2], queens[2];
+	for (int side = 0; side < 2; side++) {
+		const Piece_t offset = side ? BLACK_PAWN - WHITE_PAWN : 0;
+		pawns[side] = material_count(key, WHITE_PAWN + offset);
+		knights[side] = material_count(key, WHITE_KNIGHT + offset);
+		bishops[side] = material_count(key, WHITE_BISHOP + offset);
+		rooks[side] = material_count(key, WHITE_ROOK + offset);
+		queens[side] = material_count(key, WHITE_QUEEN + offset);
+	}
+
+	// bishop pair
+	entry.imbalance += sparams.BISHOP_PAIR * ((bishops[0] >= 2) - (bishops[1] >= 2));
+
+	// endgames without pawns, rooks or queens where the minor pieces cannot
+	// force mate: at most one minor each, or two knights against a bare king
+	bool minors_only = pawns[0] + pawns[1] + rooks[0] + rooks[1] + queens[0] + queens[1] == 0;
+	if (minors_only) {
+		unsigned int w_minors = knights[0] + bishops[0], b_minors = knights[1] + bishops[1];
+		if ((w_minors <= 1 && b_minors <= 1) ||
+			(w_minors == 0 && knights[1] == 2 && bishops[1] == 0) ||
+			(b_minors == 0 && knights[0] == 2 && bishops[0] == 0)) {
+			entry.endgame = ENDGAME_DRAW;
+			return entry;
+		}
+	}
+
+	// a bare king against pieces that can mate it
+	for (int side = 0; side < 2; side++) {
+		const int other = 1 - side;
+		bool bare = pawns[other] + knights[other] + bishops[other] + rooks[other] + queens[other] == 0;
+		bool mating = queens[side] || rooks[side] || bishops[side] >= 2 ||
+			(bishops[side] && knights[side]);
+		if (bare && mating) {
+			entry.endgame = ENDGAME_KXK;
+			entry.strong_side = side ? BLACK : WHITE;
+		}
+	}
+
+	return entry;
+}
\ No newline at end of file
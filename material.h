@@ -0,0 +1,76 @@
+/*******************************************************************************
+* Deep Winkelman
+*
+* Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
+* 14 June 2017
+*
+* Material signatures and a table of what is known about each of them.
+*
+* The material key is the count of every kind of piece, so it changes only on
+* captures and promotions and is kept in make. Terms that depend only on the
+* material (bishop pair, endgames that need their own evaluation)
+* are worked out once per key and looked up on every evaluation after that.
+*/
+
+#ifndef DEEP_WINKELMAN_MATERIAL
+#define DEEP_WINKELMAN_MATERIAL
+
+#include "move.h"
+#include "score.h"
+#include "params.h"
+
+// Count of each kind of piece other than kings, 4 bits each:
+// white pawns in the lowest bits, up to black queens in bits 36-39
+typedef uint64_t MaterialKey_t;
+
+// Amount to add to the material key for one of a piece (0 for kings and NO_PIECE)
+extern const MaterialKey_t MATERIAL_UNITS[13];
+
+// Number of a kind of piece other than kings in a material key
+inline unsigned int material_count(const MaterialKey_t key, const Piece_t piece) {
+	return (unsigned int)(key / MATERIAL_UNITS[piece]) & 15;
+}
+
+// Evaluation to use in place of the usual one for a material combination
+typedef unsigned char Endgame_t;
+#define ENDGAME_NONE 0
+// Neither side has enough material to checkmate
+#define ENDGAME_DRAW 1
+// One side has a bare king and the other has enough to checkmate it
+#define ENDGAME_KXK 2
+
+// Amount a piece adds to the game phase (0 for pawns, kings and NO_PIECE)
+extern const unsigned char PHASE_UNITS[13];
+
+struct MaterialEntry {
+	MaterialKey_t key;
+	// Score for the combination of pieces, beyond the sum of their values,
+	// for the middlegame and the endgame (see make_score)
+	Score_t imbalance;
+	Endgame_t endgame;
+	// The side with the material for ENDGAME_KXK
+	Color_t strong_side;
+};
+
+// Direct-mapped cache of material entries.
+// Each search thread should have its own.
+class MaterialTable {
+protected:
+	const static unsigned int SIZE = 1 << MATERIAL_HASH_BITS;
+	MaterialEntry entries[SIZE];
+
+	// Work out the entry for a key
+	static MaterialEntry compute(const MaterialKey_t key, const ScoreParams & sparams);
+
+public:
+	MaterialTable();
+
+	// The entry for a key, worked out and stored if it is not already there
+	inline const MaterialEntry & probe(const MaterialKey_t key, const ScoreParams & sparams) {
+		MaterialEntry & entry = entries[(key * 0x9e3779b97f4a7c15ULL) >> (64 - MATERIAL_HASH_BITS)];
+		if (entry.key != key) entry = compute(key, sparams);
+		return entry;
+	}
+};
+
+#endif
\ No newline at end of file
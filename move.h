@@ -56,6 +56,9 @@ typedef signed char Color_t;
 #define WHITE_OOO_MASK 0xe
 #define BLACK_OO_MASK 0x6000000000000000
 #define BLACK_OOO_MASK 0xe00000000000000
+// Squares the king crosses when castling queenside
+#define WHITE_OOO_KING_MASK 0xc
+#define BLACK_OOO_KING_MASK 0xc00000000000000
 
 // Move that has only information essential for making.
 // Can be a stand-alone move for 
@@ -126,6 +129,43 @@ public:
 	friend std::ostream & operator <<(std::ostream & os, const Move & pair);
 };
 
+// Fixed-capacity list of moves that can live on the stack, so filling it
+// does not touch the heap. Capacity must cover every move added.
+template<unsigned int N>
+class MoveBuffer {
+protected:
+	Move moves[N];
+	unsigned int n_moves;
+
+public:
+	MoveBuffer() : n_moves(0) {}
+
+	inline void push_back(const Move move) {
+		moves[n_moves++] = move;
+	}
+	inline void clear() {
+		n_moves = 0;
+	}
+	inline unsigned int size() const {
+		return n_moves;
+	}
+	inline bool empty() const {
+		return n_moves == 0;
+	}
+	inline Move operator[](const unsigned int index) const {
+		return moves[index];
+	}
+	inline const Move * begin() const {
+		return moves;
+	}
+	inline const Move * end() const {
+		return moves + n_moves;
+	}
+};
+
+// No legal position has more than 218 moves
+#define MAX_MOVES 256
+
 const static Move move_white_OO(WHITE_OO, 0, MOVE_CASTLING);
 const static Move move_white_OOO(WHITE_OOO, 0, MOVE_CASTLING);
 const static Move move_black_OO(BLACK_OO, 0, MOVE_CASTLING);
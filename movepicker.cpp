@@ -0,0 +1,106 @@
+/*******************************************************************************
+* Deep Winkelman
+*
+* Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
+* 6 June 2017
+*
+* Implementation for the staged move picker
+*/
+
+#include "movepicker.h"
+
+#include <utility>
+
+// Rough value of each piece for ordering captures (the king cannot be captured)
+static const Move_Rank_t PIECE_ORDER[13] = {
+	0,
+	1, 3, 3, 5, 9, 0,
+	1, 3, 3, 5, 9, 0
+};
+
+MovePicker::MovePicker(const Bitboard & board, const Move hash_move, const Move killers[2]) :
+	board(board), hash_move(hash_move) {
+	this->killers[0] = killers[0];
+	this->killers[1] = killers[1];
+	stage = STAGE_HASH_MOVE;
+	index = n_captures = n_losing_captures = 0;
+}
+
+Move_Rank_t MovePicker::capture_gain(const Move move) const {
+	Move_Rank_t gain = move.is_en_passant() ? 1 : PIECE_ORDER[board[move.end()]];
+	if (move.is_promotion()) gain += PIECE_ORDER[move.promotion_piece()] - 1;
+	return gain;
+}
+
+void MovePicker::rank_captures() {
+	n_captures = n_losing_captures = 0;
+
+	for (Move move : moves) {
+		if (move == hash_move) continue;
+		const Move_Rank_t gain = capture_gain(move), attacker = PIECE_ORDER[board[move.start()]];
+		RankedMove ranked = { move, gain * 16 - attacker };
+		// only a capture by a more valuable piece can lose the exchange
+		if (attacker > gain && board.see(move) < 0) {
+			losing_captures[n_losing_captures++] = ranked;
+			continue;
+		}
+		captures[n_captures++] = ranked;
+	}
+}
+
+Move MovePicker::pick_best(RankedMove * moves, const unsigned int n_moves, unsigned int & index) {
+	// selection sort one step at a time, since most nodes only need the first few
+	unsigned int best = index;
+	for (unsigned int i = index + 1; i < n_moves; i++) {
+		if (moves[i].rank > moves[best].rank) best = i;
+	}
+	std::swap(moves[index], moves[best]);
+	return moves[index++].move;
+}
+
+Move MovePicker::next() {
+	switch (stage) {
+	case STAGE_HASH_MOVE:
+		stage = STAGE_GENERATE_CAPTURES;
+		if (!hash_move.is_null()) return hash_move;
+	case STAGE_GENERATE_CAPTURES:
+		moves.clear();
+		board.get_moves(moves, GEN_CAPTURES);
+		rank_captures();
+		index = 0;
+		stage = STAGE_WINNING_CAPTURES;
+	case STAGE_WINNING_CAPTURES:
+		if (index < n_captures) return pick_best(captures, n_captures, index);
+		stage = STAGE_GENERATE_QUIETS;
+	case STAGE_GENERATE_QUIETS:
+		moves.clear();
+		board.get_moves(moves, GEN_QUIETS);
+		index = 0;
+		stage = STAGE_KILLERS;
+	case STAGE_KILLERS:
+		// killers come from other positions, so only play them if generated here
+		while (index < 2) {
+			Move killer = killers[index++];
+			if (killer.is_null() || killer == hash_move ||
+				(index == 2 && killer == killers[0])) continue;
+			for (Move move : moves) {
+				if (move == killer) return killer;
+			}
+		}
+		index = 0;
+		stage = STAGE_QUIETS;
+	case STAGE_QUIETS:
+		while (index < moves.size()) {
+			Move move = moves[index++];
+			if (!is_special(move)) return move;
+		}
+		index = 0;
+		stage = STAGE_LOSING_CAPTURES;
+	case STAGE_LOSING_CAPTURES:
+		if (index < n_losing_captures) return pick_best(losing_captures, n_losing_captures, index);
+		stage = STAGE_DONE;
+	case STAGE_DONE:
+	default:
+		return Move();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+/*******************************************************************************
+* Deep Winkelman
+*
+* Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
+* 6 June 2017
+*
+* Staged move picker for the search.
+*
+* Moves are handed out one at a time in the order most likely to cause a
+* cutoff. Each stage is only generated and ordered once the previous stage
+* has run out, so a node that cuts off early never pays for the rest:
+*		1. Hash move (the best move from an earlier search of the node)
+*		2. Winning and equal captures and promotions, by MVV-LVA
+*		3. Killer moves (quiet moves that caused a cutoff at the same ply)
+*		4. Quiet moves
+*		5. Losing captures (the exchange on the square loses material)
+*/
+
+#ifndef DEEP_WINKELMAN_MOVEPICKER
+#define DEEP_WINKELMAN_MOVEPICKER
+
+#include "bitboard.h"
+
+class MovePicker {
+public:
+	enum Stage {
+		STAGE_HASH_MOVE,
+		STAGE_GENERATE_CAPTURES,
+		STAGE_WINNING_CAPTURES,
+		STAGE_GENERATE_QUIETS,
+		STAGE_KILLERS,
+		STAGE_QUIETS,
+		STAGE_LOSING_CAPTURES,
+		STAGE_DONE
+	};
+
+protected:
+	struct RankedMove {
+		Move move;
+		Move_Rank_t rank;
+	};
+
+	const Bitboard & board;
+	Move hash_move, killers[2];
+	Stage stage;
+
+	// Moves of the current stage, and the position of the next one to hand out
+	MoveBuffer<MAX_MOVES> moves;
+	RankedMove captures[MAX_MOVES], losing_captures[MAX_MOVES];
+	unsigned int n_captures, n_losing_captures;
+	unsigned int index;
+
+	// Material won by a capture or promotion before any recapture
+	Move_Rank_t capture_gain(const Move move) const;
+	// Split the captures into winning and losing by static exchange
+	// evaluation and rank them by most valuable victim, least valuable attacker
+	void rank_captures();
+	// Take the best remaining ranked move
+	static Move pick_best(RankedMove * moves, const unsigned int n_moves, unsigned int & index);
+	inline bool is_special(const Move move) const {
+		return move == hash_move || move == killers[0] || move == killers[1];
+	}
+
+public:
+	// The hash move must be legal in the position or null.
+	// Killers are only used if they are legal quiet moves.
+	MovePicker(const Bitboard & board, const Move hash_move, const Move killers[2]);
+
+	// Get the next move, or a null move when there are none left
+	Move next();
+
+	inline Stage current_stage() const {
+		return stage;
+	}
+};
+
+#endif
\ No newline at end of file
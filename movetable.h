@@ -7,14 +7,25 @@
 * Type definitions for move making tables.
 *
 * A general strategy is to allocate as much move option storage as possible on
-* the stack and use static variables in frequently-accessed functions to
-* reduce allocation expenses and increase chances of caching.
+* the stack to reduce allocation expenses and increase chances of caching.
+* Tables are read-only once built, so one set of tables can be shared by any
+* number of boards and threads.
+*
+* Tables that do not depend on the position of other pieces (knight, king and
+* pawn attack sets, collision tables) are generated at compile time. Visual C++
+* 2015 only allows constexpr functions made of a single return statement, so
+* the generators below are written as expressions, and each table is filled by
+* expanding a pack of square indices in a constexpr constructor.
 */
 
 #ifndef DEEP_WINKELMAN_MOVETABLE
 #define DEEP_WINKELMAN_MOVETABLE
 
 #include <iostream>
+#include <utility>
+
+#include "params.h"
+#include "util.h"
 
 // 64-bit integer representing binary states on board squares
 typedef uint64_t Bitmask_t;
@@ -48,7 +59,36 @@ public:
 	friend std::ostream & operator <<(std::ostream & os, const MoveList & movelist);
 };
 
+// The square a step away from a square, as a bitmask, or 0 if off the board
+constexpr Bitmask_t step_mask(const int square, const int rank_step, const int file_step) {
+	return (0 <= square / 8 + rank_step && square / 8 + rank_step < 8 &&
+		0 <= square % 8 + file_step && square % 8 + file_step < 8) ?
+		one << (square + rank_step * 8 + file_step) : 0;
+}
+
+constexpr Bitmask_t knight_mask(const int square) {
+	return step_mask(square, -2, -1) | step_mask(square, -2, 1) |
+		step_mask(square, -1, -2) | step_mask(square, -1, 2) |
+		step_mask(square, 1, -2) | step_mask(square, 1, 2) |
+		step_mask(square, 2, -1) | step_mask(square, 2, 1);
+}
+
+constexpr Bitmask_t king_mask(const int square) {
+	return step_mask(square, -1, -1) | step_mask(square, -1, 0) | step_mask(square, -1, 1) |
+		step_mask(square, 0, -1) | step_mask(square, 0, 1) |
+		step_mask(square, 1, -1) | step_mask(square, 1, 0) | step_mask(square, 1, 1);
+}
+
+// Squares of a line reachable from index i onwards in one direction, stopping
+// at the first piece in combo. The blocking piece itself can be included.
+constexpr Combo_t line_reach(const int i, const int step, const int combo, const bool include_blocker) {
+	return (i < 0 || i >= 8) ? 0 :
+		((combo >> i) & 1) ? (include_blocker ? (Combo_t)(1 << i) : 0) :
+		(Combo_t)((1 << i) | line_reach(i + step, step, combo, include_blocker));
+}
+
 // Masks for how friendly and enemy pieces affect move options for linear pieces.
+// There is only one of these, shared by all of the line tables.
 class CollisionTable {
 public:
 	// Friendly piece collisions
@@ -57,9 +97,27 @@ public:
 	// Enemy piece collisions
 	Combo_t e[8][256];
 
-	CollisionTable();
+	static const CollisionTable shared;
 
-	void generate();
+	constexpr CollisionTable() : CollisionTable(std::make_index_sequence<256>()) {}
+
+protected:
+	static constexpr Combo_t collisions(const int square, const int combo, const bool enemy) {
+		return line_reach(square + 1, 1, combo, enemy) | line_reach(square - 1, -1, combo, enemy);
+	}
+
+	template<std::size_t... Combo>
+	constexpr CollisionTable(std::index_sequence<Combo...>) :
+		f{
+			{ collisions(0, Combo, false)... }, { collisions(1, Combo, false)... },
+			{ collisions(2, Combo, false)... }, { collisions(3, Combo, false)... },
+			{ collisions(4, Combo, false)... }, { collisions(5, Combo, false)... },
+			{ collisions(6, Combo, false)... }, { collisions(7, Combo, false)... } },
+		e{
+			{ collisions(0, Combo, true)... }, { collisions(1, Combo, true)... },
+			{ collisions(2, Combo, true)... }, { collisions(3, Combo, true)... },
+			{ collisions(4, Combo, true)... }, { collisions(5, Combo, true)... },
+			{ collisions(6, Combo, true)... }, { collisions(7, Combo, true)... } } {}
 };
 
 // Structure for accessing lists of moves pieces can make in a position.
@@ -87,7 +145,7 @@ public:
 
 	// Must include a function for accessing the available moves from a
 	// coordinate and a bitmask of friendly and enemy pieces on the board.
-	virtual MoveList & get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) = 0;
+	virtual const MoveList & get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) const = 0;
 };
 
 // Structure for accessing horizontal move options.
@@ -97,7 +155,6 @@ protected:
 	friend class MoveManager;
 
 	Bitmask_t masks[64];
-	CollisionTable ct;
 	MoveList moves[8][256];
 
 public:
@@ -107,7 +164,7 @@ public:
 	void generate_moves();
 	Combo_t mask_to_combo(const Coord_t coord, const Bitmask_t mask) const;
 	Bitmask_t combo_to_mask(const Coord_t coord, const Combo_t combo) const;
-	MoveList & get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy);
+	const MoveList & get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) const;
 
 protected:
 	void _tests();
@@ -120,7 +177,6 @@ protected:
 	friend class MoveManager;
 
 	Bitmask_t masks[64];
-	CollisionTable ct;
 	MoveList moves[8][256];
 
 public:
@@ -130,7 +186,7 @@ public:
 	void generate_moves();
 	Combo_t mask_to_combo(const Coord_t coord, const Bitmask_t mask) const;
 	Bitmask_t combo_to_mask(const Coord_t coord, const Combo_t combo) const;
-	MoveList & get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy);
+	const MoveList & get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) const;
 
 protected:
 	void _tests();
@@ -143,7 +199,6 @@ protected:
 	friend class MoveManager;
 
 	Bitmask_t masks[64];
-	CollisionTable ct;
 	// moves_middle is used for squares on the a1-h8 diagonal
 	// moves_low is used for squares below, moves_high used for squares above
 	// move_offsets is used to calculate the offset within moves_low and moves_high:
@@ -159,7 +214,7 @@ public:
 	void generate_moves();
 	Combo_t mask_to_combo(const Coord_t coord, const Bitmask_t mask) const;
 	Bitmask_t combo_to_mask(const Coord_t coord, const Combo_t combo) const;
-	MoveList & get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy);
+	const MoveList & get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) const;
 
 protected:
 	void _tests();
@@ -172,7 +227,6 @@ protected:
 	friend class MoveManager;
 
 	Bitmask_t masks[64];
-	CollisionTable ct;
 	// moves_middle is used for squares on the h1-a8 diagonal
 	// moves_low is used for squares below, moves_high used for squares above
 	// move_offsets is used to calculate the offset within moves_low and moves_high:
@@ -188,109 +242,79 @@ public:
 	void generate_moves();
 	Combo_t mask_to_combo(const Coord_t coord, const Bitmask_t mask) const;
 	Bitmask_t combo_to_mask(const Coord_t coord, const Combo_t combo) const;
-	MoveList & get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy);
+	const MoveList & get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) const;
 
 protected:
 	void _tests();
 };
 
-// Structure for accessing knight move options.
-// See MoveTable.
-class NMoveTable : public MoveTable {
-protected:
-	friend class MoveManager;
-
-	Bitmask_t masks[64];
-
-	Coord_t move_option_coords[64][8];
-	const int n_move_options[64]{
-		2,3,4,4,4,4,3,2,
-		3,4,6,6,6,6,4,3,
-		4,6,8,8,8,8,6,4,
-		4,6,8,8,8,8,6,4,
-		4,6,8,8,8,8,6,4,
-		4,6,8,8,8,8,6,4,
-		3,4,6,6,6,6,4,3,
-		2,3,4,4,4,4,3,2
-	};
-
-	// big block of memory to be allocated for each square
-	MoveList data[(4 * 4) + (8 * 8) + (20 * 16) + (16 * 64) + (16 * 256)];
-	// offsets in move array for each square
-	MoveList * moves[64];
-
+// Knight attack sets, generated at compile time.
+class NMoveTable {
 public:
-	NMoveTable();
+	Bitmask_t masks[64];
 
-	void generate_bitmasks();
-	void generate_moves();
-	Combo_t mask_to_combo(const Coord_t coord, const Bitmask_t mask) const;
-	Bitmask_t combo_to_mask(const Coord_t coord, const Combo_t combo) const;
-	MoveList & get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy);
+	constexpr NMoveTable() : NMoveTable(std::make_index_sequence<64>()) {}
 
 protected:
-	void _tests();
+	template<std::size_t... Square>
+	constexpr NMoveTable(std::index_sequence<Square...>) : masks{ knight_mask(Square)... } {}
 };
 
-// Structure for accessing knight move options.
-// See MoveTable.
-class KMoveTable : public MoveTable {
-protected:
-	friend class MoveManager;
-
+// King attack sets, generated at compile time.
+class KMoveTable {
+public:
 	Bitmask_t masks[64];
 
-	Coord_t move_option_coords[64][8];
-	const int n_move_options[64]{
-		3,5,5,5,5,5,5,3,
-		5,8,8,8,8,8,8,5,
-		5,8,8,8,8,8,8,5,
-		5,8,8,8,8,8,8,5,
-		5,8,8,8,8,8,8,5,
-		5,8,8,8,8,8,8,5,
-		5,8,8,8,8,8,8,5,
-		3,5,5,5,5,5,5,3
-	};
+	constexpr KMoveTable() : KMoveTable(std::make_index_sequence<64>()) {}
 
-	// big block of memory to be allocated for each square
-	MoveList data[(4 * 8) + (24 * 32) + (36 * 256)];
-	// offsets in move array for each square
-	MoveList * moves[64];
+protected:
+	template<std::size_t... Square>
+	constexpr KMoveTable(std::index_sequence<Square...>) : masks{ king_mask(Square)... } {}
+};
 
+// White pawn moves and pawn structure, with masks generated at compile time.
+class WPMoveTable {
 public:
-	KMoveTable();
+	// Squares a pawn can push to (friendly) and capture on (enemy), and both
+	Bitmask_t friendly_masks[64], enemy_masks[64], masks[64];
 
-	void generate_bitmasks();
-	void generate_moves();
-	Combo_t mask_to_combo(const Coord_t coord, const Bitmask_t mask) const;
-	Bitmask_t combo_to_mask(const Coord_t coord, const Combo_t combo) const;
-	MoveList & get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy);
+	constexpr WPMoveTable() : WPMoveTable(std::make_index_sequence<64>()) {}
 
-protected:
-	void _tests();
-};
+	Bitmask_t attacks(const Bitmask_t pawns) const;
+	unsigned int pieces_attacked(const Bitmask_t pawns, const Bitmask_t pieces) const;
+	unsigned int blocked_pawns(const Bitmask_t pawns, const Bitmask_t pieces) const;
+	unsigned int doubled_pawns(const Bitmask_t pawns) const;
+	unsigned int square_control(const Bitmask_t pawns, const Bitmask_t region) const;
+	unsigned int pawns_in_rank(const Bitmask_t pawns, const int rank) const;
+	unsigned int pawns_in_file(const Bitmask_t pawns, const int file) const;
 
-// Structure for accessing white pawn move options.
-// See MoveTable.
-class WPMoveTable : public MoveTable {
 protected:
-	friend class MoveManager;
+	// Pawns never stand on the first or last rank
+	static constexpr Bitmask_t push_mask(const int square) {
+		return (square < 8 || square >= 56) ? 0 :
+			(square < 16) ? (Bitmask_t)0x10100 << square : one << (square + 8);
+	}
+	static constexpr Bitmask_t capture_mask(const int square) {
+		return (square < 8 || square >= 56) ? 0 :
+			step_mask(square, 1, -1) | step_mask(square, 1, 1);
+	}
 
-	Bitmask_t friendly_masks[64], enemy_masks[64], masks[64];
-	Bitmask_t protection_masks[64];
-	MoveList rank_2_moves[8][16], reg_moves[40][8];
-	// Return default if no moves are legal (first/eighth ranks)
-	MoveList NULL_MOVELIST;
+	template<std::size_t... Square>
+	constexpr WPMoveTable(std::index_sequence<Square...>) :
+		friendly_masks{ push_mask(Square)... },
+		enemy_masks{ capture_mask(Square)... },
+		masks{ (push_mask(Square) | capture_mask(Square))... } {}
+};
 
+// Black pawn moves and pawn structure, with masks generated at compile time.
+class BPMoveTable {
 public:
-	WPMoveTable();
+	// Squares a pawn can push to (friendly) and capture on (enemy), and both
+	Bitmask_t friendly_masks[64], enemy_masks[64], masks[64];
 
-	void generate_bitmasks();
-	void generate_moves();
-	Combo_t mask_to_combo(const Coord_t coord, const Bitmask_t mask) const;
-	Bitmask_t combo_to_mask(const Coord_t coord, const Combo_t combo) const;
-	MoveList & get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy);
+	constexpr BPMoveTable() : BPMoveTable(std::make_index_sequence<64>()) {}
 
+	Bitmask_t attacks(const Bitmask_t pawns) const;
 	unsigned int pieces_attacked(const Bitmask_t pawns, const Bitmask_t pieces) const;
 	unsigned int blocked_pawns(const Bitmask_t pawns, const Bitmask_t pieces) const;
 	unsigned int doubled_pawns(const Bitmask_t pawns) const;
@@ -299,82 +323,134 @@ public:
 	unsigned int pawns_in_file(const Bitmask_t pawns, const int file) const;
 
 protected:
-	void _tests();
+	// Pawns never stand on the first or last rank
+	static constexpr Bitmask_t push_mask(const int square) {
+		return (square < 8 || square >= 56) ? 0 :
+			(square >= 48) ? (Bitmask_t)0x101 << (square - 16) : one << (square - 8);
+	}
+	static constexpr Bitmask_t capture_mask(const int square) {
+		return (square < 8 || square >= 56) ? 0 :
+			step_mask(square, -1, -1) | step_mask(square, -1, 1);
+	}
+
+	template<std::size_t... Square>
+	constexpr BPMoveTable(std::index_sequence<Square...>) :
+		friendly_masks{ push_mask(Square)... },
+		enemy_masks{ capture_mask(Square)... },
+		masks{ (push_mask(Square) | capture_mask(Square))... } {}
 };
 
-// Structure for accessing black pawn move options.
-// See MoveTable.
-class BPMoveTable : public MoveTable {
+// Structure for accessing rook and bishop attack sets with a single lookup.
+// Unlike the line tables above, the output is a bitmask of every square
+// attacked along all rays, including the first blocker in each direction.
+// Indexing uses fancy magic bitboards, or BMI2 PEXT if the processor supports
+// it. Which one is used is decided once when the table is constructed.
+class SliderMoveTable {
 protected:
 	friend class MoveManager;
 
-	Bitmask_t friendly_masks[64], enemy_masks[64], masks[64];
-	MoveList rank_2_moves[8][16], reg_moves[40][8];
-	// Return default if no moves are legal (first/eighth ranks)
-	MoveList NULL_MOVELIST;
+	// Lookup parameters for one square
+	struct Entry {
+		// Squares whose occupancy affects the attack set (edges excluded)
+		Bitmask_t mask;
+		// Multiplier and shift for magic indexing
+		Bitmask_t magic;
+		unsigned int shift;
+		// Start of the attack sets for this square within the shared table
+		Bitmask_t * attacks;
+	};
+
+	Entry rook_entries[64], bishop_entries[64];
+	// Attack sets for all squares and occupancies (fancy/PEXT layout)
+	Bitmask_t rook_table[0x19000], bishop_table[0x1480];
+	Bitmask_t between_masks[64][64];
+	bool use_pext;
 
 public:
-	BPMoveTable();
+	SliderMoveTable(const bool allow_pext = SLIDER_ALLOW_PEXT);
 
 	void generate_bitmasks();
 	void generate_moves();
-	Combo_t mask_to_combo(const Coord_t coord, const Bitmask_t mask) const;
-	Bitmask_t combo_to_mask(const Coord_t coord, const Combo_t combo) const;
-	MoveList & get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy);
 
-	unsigned int pieces_attacked(const Bitmask_t pawns, const Bitmask_t pieces) const;
-	unsigned int blocked_pawns(const Bitmask_t pawns, const Bitmask_t pieces) const;
-	unsigned int doubled_pawns(const Bitmask_t pawns) const;
-	unsigned int square_control(const Bitmask_t pawns, const Bitmask_t region) const;
-	unsigned int pawns_in_rank(const Bitmask_t pawns, const int rank) const;
-	unsigned int pawns_in_file(const Bitmask_t pawns, const int file) const;
+	inline Bitmask_t rook_attacks(const Coord_t coord, const Bitmask_t occupancy) const {
+		return rook_entries[coord].attacks[index(rook_entries[coord], occupancy)];
+	}
+	inline Bitmask_t bishop_attacks(const Coord_t coord, const Bitmask_t occupancy) const {
+		return bishop_entries[coord].attacks[index(bishop_entries[coord], occupancy)];
+	}
+	inline Bitmask_t queen_attacks(const Coord_t coord, const Bitmask_t occupancy) const {
+		return rook_attacks(coord, occupancy) | bishop_attacks(coord, occupancy);
+	}
+
+	// Squares strictly between two squares on the same line, otherwise 0
+	inline Bitmask_t between(const Coord_t a, const Coord_t b) const {
+		return between_masks[a][b];
+	}
+
+	// Whether the lookups are using PEXT instead of magic multiplication
+	inline bool is_using_pext() const {
+		return use_pext;
+	}
 
 protected:
+	inline unsigned int index(const Entry & entry, const Bitmask_t occupancy) const {
+#if PEXT_AVAILABLE
+		if (use_pext) return (unsigned int)pext(occupancy, entry.mask);
+#endif
+		return (unsigned int)(((occupancy & entry.mask) * entry.magic) >> entry.shift);
+	}
+
+	// Fill the attack sets for one square and check the known magic,
+	// searching for another if it does not work. Returns the number of table entries used.
+	unsigned int generate_square(Entry & entry, Bitmask_t * table,
+		const Coord_t coord, const int directions[4][2], const uint64_t known_magic);
+
 	void _tests();
 };
 
+// All of the tables needed for finding moves.
+// The line tables are not included, since sliders use SliderMoveTable.
 class MoveManager {
 public:
-	HMoveTable h_moves;
-	VMoveTable v_moves;
-	D1MoveTable d1_moves;
-	D2MoveTable d2_moves;
-	NMoveTable n_moves;
-	KMoveTable k_moves;
-	WPMoveTable wp_moves;
-	BPMoveTable bp_moves;
+	// Generated at compile time
+	static constexpr NMoveTable n_moves{};
+	static constexpr KMoveTable k_moves{};
+	static constexpr WPMoveTable wp_moves{};
+	static constexpr BPMoveTable bp_moves{};
+	// Filled on construction
+	SliderMoveTable slider_moves;
 
 	unsigned int no_piece_count(
-		const Coord_t coord, const Bitmask_t white, const Bitmask_t black) {
+		const Coord_t coord, const Bitmask_t white, const Bitmask_t black) const {
 		return 0;
 	}
 	unsigned int wp_move_count(
-		const Coord_t coord, const Bitmask_t white, const Bitmask_t black);
+		const Coord_t coord, const Bitmask_t white, const Bitmask_t black) const;
 	unsigned int bp_move_count(
-		const Coord_t coord, const Bitmask_t white, const Bitmask_t black);
+		const Coord_t coord, const Bitmask_t white, const Bitmask_t black) const;
 	unsigned int wn_move_count(
-		const Coord_t coord, const Bitmask_t white, const Bitmask_t black);
+		const Coord_t coord, const Bitmask_t white, const Bitmask_t black) const;
 	unsigned int bn_move_count(
-		const Coord_t coord, const Bitmask_t white, const Bitmask_t black);
+		const Coord_t coord, const Bitmask_t white, const Bitmask_t black) const;
 	unsigned int wb_move_count(
-		const Coord_t coord, const Bitmask_t white, const Bitmask_t black);
+		const Coord_t coord, const Bitmask_t white, const Bitmask_t black) const;
 	unsigned int bb_move_count(
-		const Coord_t coord, const Bitmask_t white, const Bitmask_t black);
+		const Coord_t coord, const Bitmask_t white, const Bitmask_t black) const;
 	unsigned int wr_move_count(
-		const Coord_t coord, const Bitmask_t white, const Bitmask_t black);
+		const Coord_t coord, const Bitmask_t white, const Bitmask_t black) const;
 	unsigned int br_move_count(
-		const Coord_t coord, const Bitmask_t white, const Bitmask_t black);
+		const Coord_t coord, const Bitmask_t white, const Bitmask_t black) const;
 	unsigned int wq_move_count(
-		const Coord_t coord, const Bitmask_t white, const Bitmask_t black);
+		const Coord_t coord, const Bitmask_t white, const Bitmask_t black) const;
 	unsigned int bq_move_count(
-		const Coord_t coord, const Bitmask_t white, const Bitmask_t black);
+		const Coord_t coord, const Bitmask_t white, const Bitmask_t black) const;
 	unsigned int wk_move_count(
-		const Coord_t coord, const Bitmask_t white, const Bitmask_t black);
+		const Coord_t coord, const Bitmask_t white, const Bitmask_t black) const;
 	unsigned int bk_move_count(
-		const Coord_t coord, const Bitmask_t white, const Bitmask_t black);
+		const Coord_t coord, const Bitmask_t white, const Bitmask_t black) const;
 
 	unsigned int(MoveManager::*move_counters[13])
-		(const Coord_t, const Bitmask_t, const Bitmask_t) = {
+		(const Coord_t, const Bitmask_t, const Bitmask_t) const = {
 		&MoveManager::no_piece_count,
 		&MoveManager::wp_move_count,
 		&MoveManager::wn_move_count,
@@ -20,15 +20,14 @@ D1MoveTable::D1MoveTable() {
 }
 
 Bitmask_t D1MoveTable::combo_to_mask(const Coord_t coord, const Combo_t combo) const {
-	static Bitmask_t output, shifted_combo;
+	Bitmask_t output, shifted_combo;
 	output = 0;
 
-	static int rank, file;
+	int rank, file;
 	rank = coord / 8, file = coord % 8;
 
 	// reduce combo by offset
-	static Combo_t offset;
-	offset = combo - move_offsets[(rank > file) ? rank - file : file - rank];
+	Combo_t offset = combo - move_offsets[(rank > file) ? rank - file : file - rank];
 
 	// shift combo to starting position
 	if (rank == file) shifted_combo = offset;
@@ -36,8 +35,7 @@ Bitmask_t D1MoveTable::combo_to_mask(const Coord_t coord, const Combo_t combo) c
 	else shifted_combo = (Bitmask_t)offset << (file - rank);
 
 	// spread combo along each row
-	static int i;
-	for (i = 0; i < 64; i += 8) {
+	for (int i = 0; i < 64; i += 8) {
 		output |= shifted_combo << i;
 	}
 
@@ -46,11 +44,11 @@ Bitmask_t D1MoveTable::combo_to_mask(const Coord_t coord, const Combo_t combo) c
 }
 
 Combo_t D1MoveTable::mask_to_combo(const Coord_t coord, const Bitmask_t mask) const {
-	static Combo_t output;
-	static Bitmask_t shifted_mask;
+	Combo_t output;
+	Bitmask_t shifted_mask;
 	output = 0;
 
-	static int rank, file;
+	int rank, file;
 	rank = coord / 8, file = coord % 8;
 
 	// shift mask to starting position and limit to the main coordinate
@@ -59,8 +57,7 @@ Combo_t D1MoveTable::mask_to_combo(const Coord_t coord, const Bitmask_t mask) co
 	else shifted_mask = (mask & masks[coord]) >> (file - rank);
 
 	// shift to a combo
-	static int i;
-	for (i = 0; i < 64; i += 8) {
+	for (int i = 0; i < 64; i += 8) {
 		output |= shifted_mask >> i;
 	}
 	
@@ -98,29 +95,29 @@ void D1MoveTable::generate_moves() {
 	}
 }
 
-MoveList & D1MoveTable::get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) {
-	static Combo_t e_combo, f_combo;
-	static Combo_t ef_mask, offset;
-	static int rank, file;
+const MoveList & D1MoveTable::get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) const {
+	Combo_t e_combo, f_combo;
+	Combo_t ef_mask, offset;
+	int rank, file;
 	rank = coord / 8, file = coord % 8;
 	ef_mask = move_offsets[abs(file - rank) + 1];
 	offset = move_offsets[abs(file - rank)];
 
 	if (rank == file) {
-		e_combo = ct.e[rank][mask_to_combo(coord, enemy)];
-		f_combo = ct.f[rank][mask_to_combo(coord, friendly)];
+		e_combo = CollisionTable::shared.e[rank][mask_to_combo(coord, enemy)];
+		f_combo = CollisionTable::shared.f[rank][mask_to_combo(coord, friendly)];
 		return moves_middle[e_combo & f_combo];
 	}
 	else if (rank > file) {
 		// upper half
-		e_combo = ct.e[file][mask_to_combo(coord, enemy)] & ~ef_mask;
-		f_combo = ct.f[file][mask_to_combo(coord, friendly)] & ~ef_mask;
+		e_combo = CollisionTable::shared.e[file][mask_to_combo(coord, enemy)] & ~ef_mask;
+		f_combo = CollisionTable::shared.f[file][mask_to_combo(coord, friendly)] & ~ef_mask;
 		return moves_high[offset + (e_combo & f_combo)];
 	}
 	else {
 		// lower half
-		e_combo = ct.e[rank][mask_to_combo(coord, enemy)] & ~ef_mask;
-		f_combo = ct.f[rank][mask_to_combo(coord, friendly)] & ~ef_mask;
+		e_combo = CollisionTable::shared.e[rank][mask_to_combo(coord, enemy)] & ~ef_mask;
+		f_combo = CollisionTable::shared.f[rank][mask_to_combo(coord, friendly)] & ~ef_mask;
 		return moves_low[offset + (e_combo & f_combo)];
 	}
 }
@@ -140,8 +137,8 @@ void D1MoveTable::_tests() {
 			std::cout << "Using rank " << rank << '\n';
 			for (int i = 0; i < 256; i++) {
 				std::cout << std::bitset<8>(i) << ":" <<
-					" Friendly " << std::bitset<8>(ct.f[rank][i]) <<
-					" Enemy " << std::bitset<8>(ct.e[rank][i]) << '\n';
+					" Friendly " << std::bitset<8>(CollisionTable::shared.f[rank][i]) <<
+					" Enemy " << std::bitset<8>(CollisionTable::shared.e[rank][i]) << '\n';
 			}
 		}
 		if (D1_MOVE_TABLE_DEBUG & MOVE_TABLE_CHECK_COMBO2MASK) {
@@ -20,15 +20,14 @@ D2MoveTable::D2MoveTable() {
 }
 
 Bitmask_t D2MoveTable::combo_to_mask(const Coord_t coord, const Combo_t combo) const {
-	static Bitmask_t output, shifted_combo;
+	Bitmask_t output, shifted_combo;
 	output = 0;
 
-	static int rank, file;
+	int rank, file;
 	rank = coord / 8, file = coord % 8;
 
 	// reduce combo by offset
-	static Combo_t offset;
-	offset = move_offsets[(file + rank < 7) ? 7 - rank - file : file + rank - 7];
+	Combo_t offset = move_offsets[(file + rank < 7) ? 7 - rank - file : file + rank - 7];
 
 	// shift combo to starting position
 	if (rank + file <= 7) shifted_combo = combo;
@@ -44,11 +43,11 @@ Bitmask_t D2MoveTable::combo_to_mask(const Coord_t coord, const Combo_t combo) c
 }
 
 Combo_t D2MoveTable::mask_to_combo(const Coord_t coord, const Bitmask_t mask) const {
-	static Combo_t output;
-	static Bitmask_t shifted_mask;
+	Combo_t output;
+	Bitmask_t shifted_mask;
 	output = 0;
 
-	static int rank, file;
+	int rank, file;
 	rank = coord / 8; file = coord % 8;
 
 	// shift combo to starting position
@@ -58,8 +57,7 @@ Combo_t D2MoveTable::mask_to_combo(const Coord_t coord, const Bitmask_t mask) co
 	shifted_mask &= masks[7];
 
 	// spread combo along each row
-	static int i;
-	for (i = 0; i < 8; i++) {
+	for (int i = 0; i < 8; i++) {
 		output |= ((shifted_mask >> ((7 - i) * 8 + i)) & 1) << i;
 	}
 
@@ -99,30 +97,30 @@ void D2MoveTable::generate_moves() {
 	}
 }
 
-MoveList & D2MoveTable::get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) {
-	static Combo_t e_combo, f_combo;
-	static Combo_t ef_mask, offset;
-	static int rank, file, index;
+const MoveList & D2MoveTable::get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) const {
+	Combo_t e_combo, f_combo;
+	Combo_t ef_mask, offset;
+	int rank, file, index;
 	rank = coord / 8, file = coord % 8;
 	index = (file + rank < 7) ? 7 - file - rank : file + rank - 7;
 	ef_mask = move_offsets[index + 1];
 	offset = move_offsets[index];
 
 	if (rank + file == 7) {
-		e_combo = ct.e[rank][mask_to_combo(coord, enemy)];
-		f_combo = ct.f[rank][mask_to_combo(coord, friendly)];
+		e_combo = CollisionTable::shared.e[rank][mask_to_combo(coord, enemy)];
+		f_combo = CollisionTable::shared.f[rank][mask_to_combo(coord, friendly)];
 		return moves_middle[e_combo & f_combo];
 	}
 	else if (rank + file > 7) {
 		// upper half
-		e_combo = ct.e[7 - rank][mask_to_combo(coord, enemy)] & ~ef_mask;
-		f_combo = ct.f[7 - rank][mask_to_combo(coord, friendly)] & ~ef_mask;
+		e_combo = CollisionTable::shared.e[7 - rank][mask_to_combo(coord, enemy)] & ~ef_mask;
+		f_combo = CollisionTable::shared.f[7 - rank][mask_to_combo(coord, friendly)] & ~ef_mask;
 		return moves_high[offset + (e_combo & f_combo)];
 	}
 	else {
 		// lower half
-		e_combo = ct.e[file][mask_to_combo(coord, enemy)] & ~ef_mask;
-		f_combo = ct.f[file][mask_to_combo(coord, friendly)] & ~ef_mask;
+		e_combo = CollisionTable::shared.e[file][mask_to_combo(coord, enemy)] & ~ef_mask;
+		f_combo = CollisionTable::shared.f[file][mask_to_combo(coord, friendly)] & ~ef_mask;
 		return moves_low[offset + (e_combo & f_combo)];
 	}
 }
@@ -142,8 +140,8 @@ void D2MoveTable::_tests() {
 			std::cout << "Using rank " << rank << '\n';
 			for (int i = 0; i < 256; i++) {
 				std::cout << std::bitset<8>(i) << ":" <<
-					" Friendly " << std::bitset<8>(ct.f[rank][i]) <<
-					" Enemy " << std::bitset<8>(ct.e[rank][i]) << '\n';
+					" Friendly " << std::bitset<8>(CollisionTable::shared.f[rank][i]) <<
+					" Enemy " << std::bitset<8>(CollisionTable::shared.e[rank][i]) << '\n';
 			}
 		}
 		if (D2_MOVE_TABLE_DEBUG & MOVE_TABLE_CHECK_COMBO2MASK) {
@@ -41,10 +41,10 @@ void HMoveTable::generate_moves() {
 	}
 }
 
-MoveList & HMoveTable::get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) {
-	static Combo_t e_combo, f_combo;
-	e_combo = ct.e[coord % 8][mask_to_combo(coord, enemy)];
-	f_combo = ct.f[coord % 8][mask_to_combo(coord, friendly)];
+const MoveList & HMoveTable::get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) const {
+	Combo_t e_combo, f_combo;
+	e_combo = CollisionTable::shared.e[coord % 8][mask_to_combo(coord, enemy)];
+	f_combo = CollisionTable::shared.f[coord % 8][mask_to_combo(coord, friendly)];
 
 	return moves[coord / 8][e_combo & f_combo];
 }
@@ -64,8 +64,8 @@ void HMoveTable::_tests() {
 			std::cout << "Using file " << file << '\n';
 			for (int i = 0; i < 256; i++) {
 				std::cout << std::bitset<8>(i) << ":" <<
-					" Friendly " << std::bitset<8>(ct.f[file][i]) <<
-					" Enemy " << std::bitset<8>(ct.e[file][i]) << '\n';
+					" Friendly " << std::bitset<8>(CollisionTable::shared.f[file][i]) <<
+					" Enemy " << std::bitset<8>(CollisionTable::shared.e[file][i]) << '\n';
 			}
 		}
 		if (H_MOVE_TABLE_DEBUG & MOVE_TABLE_CHECK_COMBO2MASK) {
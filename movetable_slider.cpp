@@ -0,0 +1,240 @@
+/******************************************************************************
+* Deep Winkelman
+*
+* Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
+* 2 June 2017
+*
+* Implementation for rook/bishop attack table using magic bitboards or PEXT.
+*/
+
+#include "debug.h"
+#include "movetable.h"
+#include "util.h"
+
+#include <string>
+
+// Directions as (rank, file) steps
+static const int ROOK_DIRECTIONS[4][2] = { {1,0},{-1,0},{0,1},{0,-1} };
+static const int BISHOP_DIRECTIONS[4][2] = { {1,1},{1,-1},{-1,1},{-1,-1} };
+
+// Seeds for the magic search on each rank
+static const uint64_t MAGIC_SEEDS[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+
+// Magics found by the search below, so that it does not have to run on startup.
+// They are still checked when the table is filled, and searched for again if wrong.
+static const uint64_t ROOK_MAGICS[64] = {
+	0x0a80004000801220ULL, 0x8040004010002008ULL, 0x2080200010008008ULL, 0x1100100008210004ULL,
+	0xc200209084020008ULL, 0x2100010004000208ULL, 0x0400081000822421ULL, 0x0200010422048844ULL,
+	0x0800800080400024ULL, 0x0001402000401000ULL, 0x3000801000802001ULL, 0x4400800800100083ULL,
+	0x0904802402480080ULL, 0x4040800400020080ULL, 0x0018808042000100ULL, 0x4040800080004100ULL,
+	0x0040048001458024ULL, 0x00a0004000205000ULL, 0x3100808010002000ULL, 0x4825010010000820ULL,
+	0x5004808008000401ULL, 0x2024818004000a00ULL, 0x0005808002000100ULL, 0x2100060004806104ULL,
+	0x0080400880008421ULL, 0x4062220600410280ULL, 0x010a004a00108022ULL, 0x0000100080080080ULL,
+	0x0021000500080010ULL, 0x0044000202001008ULL, 0x0000100400080102ULL, 0xc020128200040545ULL,
+	0x0080002000400040ULL, 0x0000804000802004ULL, 0x0000120022004080ULL, 0x010a386103001001ULL,
+	0x9010080080800400ULL, 0x8440020080800400ULL, 0x0004228824001001ULL, 0x000000490a000084ULL,
+	0x0080002000504000ULL, 0x200020005000c000ULL, 0x0012088020420010ULL, 0x0010010080080800ULL,
+	0x0085001008010004ULL, 0x0002000204008080ULL, 0x0040413002040008ULL, 0x0000304081020004ULL,
+	0x0080204000800080ULL, 0x3008804000290100ULL, 0x1010100080200080ULL, 0x2008100208028080ULL,
+	0x5000850800910100ULL, 0x8402019004680200ULL, 0x0120911028020400ULL, 0x0000008044010200ULL,
+	0x0020850200244012ULL, 0x0020850200244012ULL, 0x0000102001040841ULL, 0x140900040a100021ULL,
+	0x000200282410a102ULL, 0x000200282410a102ULL, 0x000200282410a102ULL, 0x4048240043802106ULL
+};
+static const uint64_t BISHOP_MAGICS[64] = {
+	0x40106000a1160020ULL, 0x0020010250810120ULL, 0x2010010220280081ULL, 0x002806004050c040ULL,
+	0x0002021018000000ULL, 0x2001112010000400ULL, 0x0881010120218080ULL, 0x1030820110010500ULL,
+	0x0000120222042400ULL, 0x2000020404040044ULL, 0x8000480094208000ULL, 0x0003422a02000001ULL,
+	0x000a220210100040ULL, 0x8004820202226000ULL, 0x0018234854100800ULL, 0x0100004042101040ULL,
+	0x0004001004082820ULL, 0x0010000810010048ULL, 0x1014004208081300ULL, 0x2080818802044202ULL,
+	0x0040880c00a00100ULL, 0x0080400200522010ULL, 0x0001000188180b04ULL, 0x0080249202020204ULL,
+	0x1004400004100410ULL, 0x00013100a0022206ULL, 0x2148500001040080ULL, 0x4241080011004300ULL,
+	0x4020848004002000ULL, 0x10101380d1004100ULL, 0x0008004422020284ULL, 0x01010a1041008080ULL,
+	0x0808080400082121ULL, 0x0808080400082121ULL, 0x0091128200100c00ULL, 0x0202200802010104ULL,
+	0x8c0a020200440085ULL, 0x01a0008080b10040ULL, 0x0889520080122800ULL, 0x100902022202010aULL,
+	0x04081a0816002000ULL, 0x0000681208005000ULL, 0x8170840041008802ULL, 0x0a00004200810805ULL,
+	0x0830404408210100ULL, 0x2602208106006102ULL, 0x1048300680802628ULL, 0x2602208106006102ULL,
+	0x0602010120110040ULL, 0x0941010801043000ULL, 0x000040440a210428ULL, 0x0008240020880021ULL,
+	0x0400002012048200ULL, 0x00ac102001210220ULL, 0x0220021002009900ULL, 0x84440c080a013080ULL,
+	0x0001008044200440ULL, 0x0004c04410841000ULL, 0x2000500104011130ULL, 0x1a0c010011c20229ULL,
+	0x0044800112202200ULL, 0x0434804908100424ULL, 0x0300404822c08200ULL, 0x48081010008a2a80ULL
+};
+
+// Check the processor for BMI2 support
+static bool cpu_has_bmi2() {
+#if defined(_MSC_VER) && defined(_M_X64)
+	int info[4];
+	__cpuidex(info, 7, 0);
+	return (info[1] >> 8) & 1;
+#elif defined(__GNUC__) && defined(__x86_64__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("bmi2") != 0;
+#else
+	return false;
+#endif
+}
+
+// Xorshift generator with a fixed seed so that magics are the same every run
+class MagicGenerator {
+	uint64_t state;
+public:
+	MagicGenerator(const uint64_t seed) : state(seed) {}
+	uint64_t next() {
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 2685821657736338717ULL;
+	}
+	// Magics with few bits set are found much faster
+	uint64_t next_sparse() {
+		return next() & next() & next();
+	}
+};
+
+// Walk each ray from a square until hitting a piece or the edge of the board
+static Bitmask_t sliding_attacks(const Coord_t coord, const Bitmask_t occupancy,
+	const int directions[4][2]) {
+	Bitmask_t output = 0;
+	for (int d = 0; d < 4; d++) {
+		int x = coord / 8 + directions[d][0], y = coord % 8 + directions[d][1];
+		for (; 0 <= x && x < 8 && 0 <= y && y < 8; x += directions[d][0], y += directions[d][1]) {
+			output |= one << (x * 8 + y);
+			if ((occupancy >> (x * 8 + y)) & 1) break;
+		}
+	}
+	return output;
+}
+
+// Squares along each ray that can block, excluding the last square on the edge
+static Bitmask_t relevant_mask(const Coord_t coord, const int directions[4][2]) {
+	Bitmask_t output = 0;
+	for (int d = 0; d < 4; d++) {
+		int x = coord / 8 + directions[d][0], y = coord % 8 + directions[d][1];
+		for (; 0 <= x + directions[d][0] && x + directions[d][0] < 8 &&
+			0 <= y + directions[d][1] && y + directions[d][1] < 8;
+			x += directions[d][0], y += directions[d][1]) {
+			output |= one << (x * 8 + y);
+		}
+	}
+	return output;
+}
+
+SliderMoveTable::SliderMoveTable(const bool allow_pext) {
+	use_pext = PEXT_AVAILABLE && allow_pext && cpu_has_bmi2();
+	generate_bitmasks();
+	generate_moves();
+	_tests();
+}
+
+void SliderMoveTable::generate_bitmasks() {
+	for (int i = 0; i < 64; i++) {
+		rook_entries[i].mask = relevant_mask(i, ROOK_DIRECTIONS);
+		rook_entries[i].shift = 64 - popcount(rook_entries[i].mask);
+		bishop_entries[i].mask = relevant_mask(i, BISHOP_DIRECTIONS);
+		bishop_entries[i].shift = 64 - popcount(bishop_entries[i].mask);
+	}
+}
+
+void SliderMoveTable::generate_moves() {
+	unsigned int rook_offset = 0, bishop_offset = 0;
+	for (int i = 0; i < 64; i++) {
+		rook_offset += generate_square(rook_entries[i], rook_table + rook_offset,
+			i, ROOK_DIRECTIONS, ROOK_MAGICS[i]);
+		bishop_offset += generate_square(bishop_entries[i], bishop_table + bishop_offset,
+			i, BISHOP_DIRECTIONS, BISHOP_MAGICS[i]);
+	}
+
+	// rays from each square meet only between squares on a shared line
+	for (int a = 0; a < 64; a++) {
+		for (int b = 0; b < 64; b++) {
+			Bitmask_t a_mask = one << a, b_mask = one << b;
+			if (rook_attacks(a, 0) & b_mask)
+				between_masks[a][b] = rook_attacks(a, b_mask) & rook_attacks(b, a_mask);
+			else if (bishop_attacks(a, 0) & b_mask)
+				between_masks[a][b] = bishop_attacks(a, b_mask) & bishop_attacks(b, a_mask);
+			else
+				between_masks[a][b] = 0;
+		}
+	}
+}
+
+unsigned int SliderMoveTable::generate_square(Entry & entry, Bitmask_t * table,
+	const Coord_t coord, const int directions[4][2], const uint64_t known_magic) {
+	Bitmask_t occupancies[4096], references[4096];
+	int attempts[4096] = {};
+	unsigned int size = 0;
+
+	// Enumerate all subsets of the mask with the Carry-Rippler trick.
+	// Subsets come out in the same order as their PEXT indices.
+	Bitmask_t subset = 0;
+	do {
+		occupancies[size] = subset;
+		references[size] = sliding_attacks(coord, subset, directions);
+		size++;
+		subset = (subset - entry.mask) & entry.mask;
+	} while (subset);
+
+	entry.attacks = table;
+	entry.magic = 0;
+
+	if (use_pext) {
+		for (unsigned int i = 0; i < size; i++) {
+			table[i] = references[i];
+		}
+		return size;
+	}
+
+	// Search for a magic that maps every occupancy to a non-conflicting index,
+	// starting with the known one.
+	// Seeded by rank so the search is repeatable; these seeds find magics quickly.
+	MagicGenerator generator(MAGIC_SEEDS[coord / 8]);
+	for (int attempt = 1;; attempt++) {
+		if (attempt == 1) entry.magic = known_magic;
+		else do {
+			entry.magic = generator.next_sparse();
+		} while (popcount((entry.mask * entry.magic) >> 56) < 6);
+
+		unsigned int i;
+		for (i = 0; i < size; i++) {
+			unsigned int idx = (unsigned int)((occupancies[i] * entry.magic) >> entry.shift);
+			if (attempts[idx] < attempt) {
+				attempts[idx] = attempt;
+				table[idx] = references[i];
+			}
+			else if (table[idx] != references[i]) {
+				break;
+			}
+		}
+		if (i == size) break;
+	}
+	return size;
+}
+
+void SliderMoveTable::_tests() {
+	// Run tests
+	if (MASTER_DEBUG) {
+		if (SLIDER_MOVE_TABLE_DEBUG & MOVE_TABLE_CHECK_MASKS) {
+			std::cout << "TEST: SliderMoveTable Masks\n";
+			for (int i = 0; i < 64; i++) {
+				std::cout << i << " Rook\n" << print_mask(rook_entries[i].mask)
+					<< i << " Bishop\n" << print_mask(bishop_entries[i].mask) << '\n';
+			}
+		}
+		if (SLIDER_MOVE_TABLE_DEBUG & MOVE_TABLE_CHECK_MOVES) {
+			std::cout << "TEST: SliderMoveTable Moves ("
+				<< (use_pext ? "PEXT" : "magics") << ")\n";
+			MagicGenerator generator(1);
+			int failures = 0;
+			for (int i = 0; i < 64; i++) {
+				for (int n = 0; n < 1000; n++) {
+					Bitmask_t occupancy = generator.next_sparse();
+					if (rook_attacks(i, occupancy) != sliding_attacks(i, occupancy, ROOK_DIRECTIONS) ||
+						bishop_attacks(i, occupancy) != sliding_attacks(i, occupancy, BISHOP_DIRECTIONS)) {
+						failures++;
+					}
+				}
+			}
+			if (failures == 0) std::cout << "Reference test PASSED\n\n";
+			else std::cout << "Reference test FAILED (" << failures << " failures)\n\n";
+		}
+	}
+}
\ No newline at end of file
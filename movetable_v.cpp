@@ -20,25 +20,21 @@ VMoveTable::VMoveTable() {
 }
 
 Bitmask_t VMoveTable::combo_to_mask(const Coord_t coord, const Combo_t combo) const {
-	static Bitmask_t output, shifted_combo;
+	Bitmask_t output, shifted_combo;
 	output = 0;
 	shifted_combo = (Bitmask_t)combo << (coord % 8);
 
-	static int i;
-	for (i = 0; i < 56; i += 7) {
+	for (int i = 0; i < 56; i += 7) {
 		output |= shifted_combo << i;
 	}
 	return output & masks[coord];
 }
 
 Combo_t VMoveTable::mask_to_combo(const Coord_t coord, const Bitmask_t mask) const {
-	static Combo_t output;
-	output = 0;
-	static Bitmask_t shifted_mask;
-	shifted_mask = (mask & masks[coord]) >> (coord % 8);
+	Combo_t output = 0;
+	Bitmask_t shifted_mask = (mask & masks[coord]) >> (coord % 8);
 
-	static int i;
-	for (i = 0; i < 56; i += 7) {
+	for (int i = 0; i < 56; i += 7) {
 		output |= 0xff & (shifted_mask >> i);
 	}
 	return output;
@@ -58,10 +54,10 @@ void VMoveTable::generate_moves() {
 	}
 }
 
-MoveList & VMoveTable::get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) {
-	static Combo_t e_combo, f_combo;
-	e_combo = ct.e[coord / 8][mask_to_combo(coord, enemy)];
-	f_combo = ct.f[coord / 8][mask_to_combo(coord, friendly)];
+const MoveList & VMoveTable::get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) const {
+	Combo_t e_combo, f_combo;
+	e_combo = CollisionTable::shared.e[coord / 8][mask_to_combo(coord, enemy)];
+	f_combo = CollisionTable::shared.f[coord / 8][mask_to_combo(coord, friendly)];
 
 	return moves[coord % 8][e_combo & f_combo];
 }
@@ -81,8 +77,8 @@ void VMoveTable::_tests() {
 			std::cout << "Using rank " << rank << '\n';
 			for (int i = 0; i < 256; i++) {
 				std::cout << std::bitset<8>(i) << ":" <<
-					" Friendly " << std::bitset<8>(ct.f[rank][i]) <<
-					" Enemy " << std::bitset<8>(ct.e[rank][i]) << '\n';
+					" Friendly " << std::bitset<8>(CollisionTable::shared.f[rank][i]) <<
+					" Enemy " << std::bitset<8>(CollisionTable::shared.e[rank][i]) << '\n';
 			}
 		}
 		if (V_MOVE_TABLE_DEBUG & MOVE_TABLE_CHECK_COMBO2MASK) {
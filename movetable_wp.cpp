@@ -4,87 +4,23 @@
 * Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
 * 23 April 2017
 *
-* Implementation for white pawn move table
+* White pawn move table, with masks generated at compile time.
 */
 
-#include <bitset>
-#include <string>
-
-#include "debug.h"
 #include "movetable.h"
 #include "util.h"
 
-WPMoveTable::WPMoveTable() {
-	generate_bitmasks();
-	generate_moves();
-	_tests();
-}
-
-Bitmask_t WPMoveTable::combo_to_mask(const Coord_t coord, const Combo_t combo) const {
-	return (((Bitmask_t)(combo & 7) << (coord + 7))
-		| ((Bitmask_t)(combo & 8) << (coord + 13)))
-		& masks[coord];
-}
-
-Combo_t WPMoveTable::mask_to_combo(const Coord_t coord, const Bitmask_t mask) const {
-	static Bitmask_t adjusted;
-	adjusted = mask & masks[coord];
-	return ((adjusted >> (coord + 7)) & 7) | ((adjusted >> (coord + 13)) & 8);
-}
-
-void WPMoveTable::generate_bitmasks() {
-	for (int i = 0; i < 8; i++) {
-		friendly_masks[i] = enemy_masks[i] = protection_masks[i] = 0;
-	}
-	for (int i = 8; i < 16; i++) {
-		friendly_masks[i] = (Bitmask_t)0x10100 << i;
-		enemy_masks[i] = ((Bitmask_t)5 << (i + 7)) & 0xff0000;
-		protection_masks[i] = enemy_masks[i] | (one << i);
-	}
-	for (int i = 16; i < 56; i++) {
-		friendly_masks[i] = one << (i + 8);
-		enemy_masks[i] = ((Bitmask_t)5 << (i + 7)) & ((Bitmask_t)0xff00 << ((i / 8) * 8));
-		protection_masks[i] = enemy_masks[i] | (one << i);
-	}
-	for (int i = 56; i < 64; i++) {
-		friendly_masks[i] = enemy_masks[i] = protection_masks[i] = 0;
-	}
-	for (int i = 0; i < 64; i++) {
-		masks[i] = friendly_masks[i] | enemy_masks[i];
-	}
-}
+constexpr WPMoveTable MoveManager::wp_moves;
 
-void WPMoveTable::generate_moves() {
-	for (int i = 8; i < 16; i++) {
-		for (int combo = 0; combo < 16; combo++) {
-			rank_2_moves[i - 8][combo] = MoveList(combo_to_mask(i, combo));
-		}
-	}
-	for (int i = 16; i < 56; i++) {
-		for (int combo = 0; combo < 8; combo++) {
-			reg_moves[i - 16][combo] = MoveList(combo_to_mask(i, combo));
-		}
-	}
-}
+// Spot checks, done by the compiler
+static_assert(MoveManager::wp_moves.friendly_masks[8] == 0x0000000001010000, "double push from a2");
+static_assert(MoveManager::wp_moves.enemy_masks[27] == 0x0000001400000000, "captures from d4");
+static_assert(MoveManager::wp_moves.masks[55] == 0xc000000000000000, "promotions from h7");
 
-MoveList & WPMoveTable::get_movelist(const Coord_t coord, const Bitmask_t friendly, const Bitmask_t enemy) {
-	if (8 <= coord && coord < 16) {
-		Combo_t combo = mask_to_combo(coord,
-			(friendly_masks[coord] & ~friendly) | (enemy_masks[coord] & enemy));
-		return rank_2_moves[coord - 8][mask_to_combo(coord,
-			(friendly_masks[coord] & ~friendly) | (enemy_masks[coord] & enemy))];
-			
-	}
-	else if (16 <= coord && coord < 56) {
-		return reg_moves[coord - 16][
-			mask_to_combo(coord,
-				(friendly_masks[coord] & ~(friendly | enemy)) | (enemy_masks[coord] & enemy))];
-	}
-	else {
-		return NULL_MOVELIST;
-	}
+// Get the squares attacked by pawns
+Bitmask_t WPMoveTable::attacks(const Bitmask_t pawns) const {
+	return ((pawns << 7) & 0x7f7f7f7f7f7f7f7f) | ((pawns << 9) & 0xfefefefefefefefe);
 }
-
 // Get the number of pieces attacked by pawns
 unsigned int WPMoveTable::pieces_attacked(const Bitmask_t pawns, const Bitmask_t pieces) const {
 	Bitmask_t pairs1 = (pawns << 7) & pieces & 0x7f7f7f7f7f7f7f7f;
@@ -125,60 +61,4 @@ unsigned int WPMoveTable::pawns_in_rank(const Bitmask_t pawns, const int rank) c
 // Get the number of pawns in a file
 unsigned int WPMoveTable::pawns_in_file(const Bitmask_t pawns, const int file) const {
 	return popcount_max15(pawns & (0x0101010101010101 << file));
-}
-
-void WPMoveTable::_tests() {
-	// Run tests
-	if (MASTER_DEBUG) {
-		if (WP_MOVE_TABLE_DEBUG & MOVE_TABLE_CHECK_MASKS) {
-			std::cout << "TEST: WPMoveTable Masks\n";
-			for (int i = 0; i < 64; i++) {
-				std::cout << i << '\n' << print_mask(masks[i]) << '\n';
-			}
-		}
-		if (WP_MOVE_TABLE_DEBUG & MOVE_TABLE_CHECK_CT) {
-			int file = 3;
-			std::cout << "TEST: WPMoveTable Collision Tables\n";
-			std::cout << "Using file " << file << '\n';
-			for (int i = 0; i < 64; i++) {
-				std::cout << "Enemy " << i << '\n' << print_mask(enemy_masks[i]) << '\n';
-				std::cout << "Friendly " << i << '\n' << print_mask(friendly_masks[i]) << '\n';
-			}
-		}
-		if (WP_MOVE_TABLE_DEBUG & MOVE_TABLE_CHECK_COMBO2MASK) {
-			Coord_t square = 14;
-			std::cout << "TEST: WPMoveTable Combo to Mask and Mask to Combo\n";
-			std::cout << "Using square " << (int)square << '\n';
-			for (int i = 0; i < 16; i++) {
-				std::cout << "Combo " << i << '\n' << print_mask(combo_to_mask(square, i));
-				if (mask_to_combo(square, combo_to_mask(square, i)) == i) {
-					std::cout << "Reverse test PASSED\n\n";
-				}
-				else {
-					std::cout << "Reverse test FAILED\n\n";
-				}
-			}
-			square = 34;
-			std::cout << "TEST: WPMoveTable Combo to Mask and Mask to Combo\n";
-			std::cout << "Using square " << (int)square << '\n';
-			for (int i = 0; i < 16; i++) {
-				std::cout << "Combo " << i << '\n' << print_mask(combo_to_mask(square, i));
-				if (mask_to_combo(square, combo_to_mask(square, i)) == i) {
-					std::cout << "Reverse test PASSED\n\n";
-				}
-				else {
-					std::cout << "Reverse test FAILED\n\n";
-				}
-			}
-		}
-		if (WP_MOVE_TABLE_DEBUG & MOVE_TABLE_CHECK_MOVES) {
-			Coord_t square = 14;
-			std::cout << "TEST: WPMoveTable Moves\n";
-			std::cout << "Using square " << (int)square << '\n';
-			for (int i = 0; i < 16; i++) {
-				std::cout << "Combo " << i << " Mask " << combo_to_mask(square, i)
-					<< " " << rank_2_moves[square - 8][i] << '\n';
-			}
-		}
-	}
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
 
 #include "node.h"
 #include "bitboard.h"
+#include "movepicker.h"
 #include "util.h"
 #include "errors.h"
 
@@ -20,6 +21,8 @@ TranspositionTable Node::ttable = TranspositionTable();
 
 int Node::searched_nodes = 0;
 
+Move Node::killers[MAX_SEARCH_DEPTH][2];
+
 Node::Node() {
 	color = WHITE;
 	allocated = NODE_NOT_ALLOCATED;
@@ -37,7 +40,15 @@ Node::Node(const Color_t color, const Score_t score) {
 }
 
 void Node::populate(Bitboard & bitboard, Bitboard::ScoreFunction score_function){
-	std::vector<Move> moves = bitboard.get_moves();
+	MoveBuffer<MAX_MOVES> moves;
+	bitboard.get_moves(moves);
+
+	// checkmate or stalemate ends the game, so there is nothing to expand
+	if (moves.empty()) {
+		_score = bitboard.in_check() ? SCORE_BLACK_WIN : SCORE_DRAW;
+		return;
+	}
+
 	this->children.reserve(moves.size());
 	counter += moves.size();
 	int color_multiplier = (color == WHITE) ? -1 : 1;
@@ -56,6 +67,93 @@ void Node::populate(Bitboard & bitboard, Bitboard::ScoreFunction score_function)
 	searched_nodes += children.size();
 }
 
+void Node::populate_lazy(Bitboard & bitboard, const Score_t alpha, const Score_t beta) {
+	MoveBuffer<MAX_MOVES> moves;
+	bitboard.get_moves(moves);
+
+	if (moves.empty()) {
+		_score = bitboard.in_check() ? SCORE_BLACK_WIN : SCORE_DRAW;
+		return;
+	}
+
+	this->children.reserve(moves.size());
+	counter += moves.size();
+	int color_multiplier = (color == WHITE) ? -1 : 1;
+
+	// children are scored from white's point of view, so the window is turned
+	// around when black is to move
+	const Score_t white_alpha = (color == WHITE) ? alpha : -beta;
+	const Score_t white_beta = (color == WHITE) ? beta : -alpha;
+
+	for (Move move : moves) {
+		bool capture = bitboard.make(move);
+		children.push_back(MoveNodePair(
+			NodePointer(bitboard.score_lazy(white_alpha, white_beta) * color_multiplier, capture), move
+		));
+		bitboard.unmake();
+	}
+
+	searched_nodes += children.size();
+}
+
+MoveNodePair & Node::add_child(Bitboard & board, const Move move) {
+	// children left over from an earlier search of this node are reused
+	for (MoveNodePair & pair : children) {
+		if (pair.move == move) return pair;
+	}
+
+	bool capture = board.make(move);
+	Score_t score = board.score_level_1() * ((color == WHITE) ? -1 : 1);
+	board.unmake();
+
+	children.push_back(MoveNodePair(NodePointer(score, capture), move));
+	counter++;
+	searched_nodes++;
+	return children.back();
+}
+
+void Node::store_killer(const int ply, const Move move) {
+	if (killers[ply][0] != move) {
+		killers[ply][1] = killers[ply][0];
+		killers[ply][0] = move;
+	}
+}
+
+void Node::clear_killers() {
+	for (int ply = 0; ply < MAX_SEARCH_DEPTH; ply++) {
+		killers[ply][0] = killers[ply][1] = Move();
+	}
+}
+
+Score_t Node::search_without_tree(Bitboard & board, const int remaining,
+	TreeOptions options, Score_t alpha, const Score_t beta) {
+	if (board.is_draw()) return SCORE_DRAW;
+	if (remaining <= 0) {
+		searched_nodes++;
+		if (board.current_data().color == WHITE) {
+			return (options & LAZY_EVALUATION) ? board.score_lazy(alpha, beta) : board.score_level_1();
+		}
+		return -((options & LAZY_EVALUATION) ? board.score_lazy(-beta, -alpha) : board.score_level_1());
+	}
+
+	MovePicker picker(board, Move(), killers[board.ply()]);
+	bool any_moves = false;
+	for (Move move = picker.next(); !move.is_null(); move = picker.next()) {
+		any_moves = true;
+		board.make(move);
+		Score_t score = -search_without_tree(board, remaining - 1, options, -beta, -alpha);
+		board.unmake();
+
+		// fail hard, the same as create_tree
+		if (score >= beta) return score;
+		if (score > alpha) alpha = score;
+	}
+
+	// checkmate or stalemate
+	if (!any_moves) return board.in_check() ? SCORE_BLACK_WIN : SCORE_DRAW;
+	return alpha;
+}
+
 MoveNodePair & Node::find_move(const Move move) {
 	// Use binary search to locate moves since they are in order
 	// Determine the size of the data
@@ -94,87 +192,87 @@ MoveNodePair & Node::find_move(const Move move) {
 Score_t Node::create_tree(Bitboard & board, int remaining,
 	TreeOptions options, Bitboard::MoveRankFunction move_rank_function,
 	Score_t alpha, Score_t beta) {
-	// generate the list of available moves along with node pointers
-	// (this includes preliminary scores)
-	populate(board, &Bitboard::score_level_1);
-
 	// alpha-beta pruning
-	// since moves are sorted in order of goodness, bad moves at the end can be pruned
+	// since moves are picked in order of likely goodness, bad moves at the end can be pruned
 	// alpha and beta values are passed through arguments
 	// they are not kept as records
 	Score_t last_node_score = 0;
 
-	// sort moves by ranking of potential before doing alpha-beta pruning
 	if (options & PRESORT_MOVES && remaining > 2) {
-		
-		// load moves and ranks into a vector to be sorted
-		std::vector<MoveRank> ranked(children.size());
-		std::vector<MoveRank>::iterator rank_it = ranked.begin();
-		for (MoveNodePair & pair : children) {
-			*rank_it = MoveRank(&pair, (board.*move_rank_function)(pair.move));
-			++rank_it;
+		// null move pruning: if the other side cannot reach beta even when given
+		// a free move, a real move would fail high as well. Passing is illegal
+		// in check, and with only pawns left zugzwang makes it unsafe.
+		// The null search keeps no nodes, so it is never followed by another.
+		const int null_remaining = remaining - 1 - NULL_MOVE_REDUCTION;
+		if ((options & NULL_MOVE_PRUNING) && null_remaining > 0 &&
+			!board.in_check() && board.has_pieces(board.current_data().color)) {
+			board.make_null();
+			Score_t null_score = -search_without_tree(board, null_remaining, options, -beta, -beta + 1);
+			board.unmake_null();
+			if (null_score >= beta) {
+				_score = null_score;
+				return null_score;
+			}
 		}
-		std::sort(ranked.begin(), ranked.end(), &MoveRank::first_greater_than_second);
 
-		// go through each move and do same as below
-		
-		for(MoveRank & rank : ranked){
+		// moves are generated and ordered one stage at a time, and children are
+		// only created for moves that are searched, so a cutoff skips the rest
+		// the best move from an earlier search of this node is tried first
+		Move hash_move = children.empty() ? Move() : best_node()->move;
+		MovePicker picker(board, hash_move, killers[board.ply()]);
+
+		for (Move move = picker.next(); !move.is_null(); move = picker.next()) {
+			MoveNodePair & pair = add_child(board, move);
 
 			// perform this function on children
-			last_node_score = -recurse_create_tree(rank.pair->move, rank.pair->node,
-				board, remaining, options, move_rank_function, -alpha, -beta);
+			last_node_score = -recurse_create_tree(pair.move, pair.node,
+				board, remaining, options, move_rank_function, -beta, -alpha);
 
 			// using fail hard negamax
 			// https://chessprogramming.wikispaces.com/Alpha-Beta
 			if (last_node_score >= beta) {
+				if (move.is_castling() || (move.is_normal() && board[move.end()] == NO_PIECE))
+					store_killer(board.ply(), move);
 				_score = last_node_score;
 				return last_node_score;
 			}
 			if (last_node_score > alpha) {
 				alpha = last_node_score;
 			}
+		}
 
-			/*
-			// set alpha/beta score of this node
-			// alpha beta only applies when nodes are presorted
-
-			_score = std::max(last_node_score, _score);
-			if (color == WHITE) {
-				alpha = std::max(-last_node_score, alpha);
-				//_score = std::max(last_node_score, _score);
-			}
-			else {
-				beta = std::min(last_node_score, beta);
-				//_score = std::min(last_node_score, _score);
-			}
-
-			// check if alpha beta has diverged
-			// if so, break from the loop
-			if (beta < alpha)
-				break;
-			*/
+		// checkmate or stalemate ends the game, so there is nothing to expand
+		if (children.empty()) {
+			_score = board.in_check() ? SCORE_BLACK_WIN : SCORE_DRAW;
+			return score();
 		}
 		_score = alpha;
 	}
 	else {
+		// generate the list of available moves along with node pointers
+		// (this includes preliminary scores)
+		// the window only means something in an alpha-beta search
+		if ((options & PRESORT_MOVES) && (options & LAZY_EVALUATION))
+			populate_lazy(board, alpha, beta);
+		else
+			populate(board, &Bitboard::score_level_1);
+		if (children.empty()) return score();
+
 		// perform operations on each child node
+		_score = SCORE_BLACK_WIN;
 		for (MoveNodePair & node : children){
 			if (remaining > 1) {
 				// perform this function on children
 				last_node_score = -recurse_create_tree(node.move, node.node,
-					board, remaining, options, move_rank_function, -alpha, -beta);
+					board, remaining, options, move_rank_function, -beta, -alpha);
+			}
+			else {
+				// preliminary scores are from the point of view of the child
+				last_node_score = -node.node.get_score();
 			}
 
 			// set score of this node
 			if (last_node_score > _score) _score = last_node_score;
-			/*if (color == WHITE) {
-				// alpha = std::max(node_it->get_score(), alpha);
-				_score = std::max(-node_it->get_score(), _score);
-			}
-			else {
-				// beta = std::min(node_it->get_score(), beta);
-				_score = std::min(-node_it->get_score(), _score);
-			}*/
 		}
 	}
 
@@ -188,9 +286,22 @@ Score_t Node::recurse_create_tree(Move move, NodePointer & nptr,
 	// make the move to the bitboard
 	bool capture = board.make(move);
 
+	// a repetition or the fifty-move rule ends the line in a draw.
+	// This depends on how the position was reached, so it is kept as a score
+	// and not shared through the transposition table.
+	if (!nptr.is_pointer() && board.is_draw()) {
+		nptr.set_score(SCORE_DRAW);
+		board.unmake();
+		return nptr.get_score();
+	}
+
 	// check prior existance in transposition table
 	Node * child = ttable.get(board.current_data().hash);
-	if (child) {
+	if (nptr.is_pointer()) {
+		// search the existing node again
+		nptr.get_node().create_tree(board, remaining - 1, options, move_rank_function, alpha, beta);
+	}
+	else if (child) {
 		child->add_parent(&nptr);
 		nptr.convert(child->color == WHITE ? BLACK : WHITE);
 	}
@@ -37,6 +37,7 @@
 
 #include <map>
 #include <array>
+#include <utility>
 
 #include "bitboard.h"
 #include "score.h"
@@ -66,6 +67,10 @@ public:
 	NodePointer();
 	NodePointer(const Score_t score, bool capture);
 	NodePointer(Node * node);
+	// A node pointer owns its node, so moving it hands the node over
+	// instead of deleting it when the old copy is destroyed
+	NodePointer(NodePointer && other);
+	NodePointer & operator =(NodePointer && other);
 	~NodePointer();
 	void set_score(const Score_t score);
 	void set_node(Node * node);
@@ -86,10 +91,7 @@ public:
 struct MoveNodePair {
 	Move move;
 	NodePointer node;
-	MoveNodePair(NodePointer node, Move move) {
-		this->node = node;
-		this->move = move;
-	}
+	MoveNodePair(NodePointer node, Move move) : move(move), node(std::move(node)) {}
 	friend std::ostream & operator <<(std::ostream & os, std::vector<MoveNodePair *> & moves);
 	static bool first_greater_than_second(MoveNodePair & first, MoveNodePair & second) {
 		return first.node.get_score() > second.node.get_score();
@@ -129,6 +131,11 @@ public:
 
 	static int searched_nodes;
 
+	// Quiet moves that caused a cutoff at each ply, most recent first
+	static Move killers[MAX_SEARCH_DEPTH][2];
+	// Forget the killers, so that a search is not ordered by an earlier one
+	static void clear_killers();
+
 public:
 	static unsigned int counter;
 
@@ -158,14 +165,23 @@ public:
 		NO_TREE_OPTIONS = 0x00,
 		// Extend the tree automatically when a capture is made
 		FOLLOW_CAPTURES = 0x01,
-		// Sort move options before expanding
-		PRESORT_MOVES = 0x02
+		// Search moves in order from a staged move picker and prune with alpha-beta
+		PRESORT_MOVES = 0x02,
+		// With PRESORT_MOVES, skip a node if passing the move to the other side
+		// still fails high in a search reduced by NULL_MOVE_REDUCTION
+		NULL_MOVE_PRUNING = 0x04,
+		// With PRESORT_MOVES, score leaves with Bitboard::score_lazy
+		LAZY_EVALUATION = 0x08
 	};
 
 	// Create NodePointers to all possible moves in the position
 	// Assuming that the bitboard is already in position for the node
 	// Have the option of choosing the method to determine the score of each node
+	// If there are no legal moves, the node is scored as checkmate or stalemate
 	void populate(Bitboard & bitboard, Bitboard::ScoreFunction score_function);
+	// Populate with Bitboard::score_lazy, for a node searched with a window
+	// from the point of view of its side to move
+	void populate_lazy(Bitboard & bitboard, const Score_t alpha, const Score_t beta);
 	
 	// Generate a uniform move tree starting from this node of depth
 	// The depth includes a layer of NodePointers
@@ -184,6 +200,15 @@ public:
 	friend std::ostream & operator <<(std::ostream & os, const Node & node);
 
 protected:
+	// Get the child for a move, creating it with a preliminary score if needed
+	MoveNodePair & add_child(Bitboard & board, const Move move);
+	// Remember a quiet move that caused a cutoff at a ply
+	static void store_killer(const int ply, const Move move);
+	// Alpha-beta search that keeps no nodes, for the null move search.
+	// Scores are for the side to move, the same as create_tree.
+	static Score_t search_without_tree(Bitboard & board, const int remaining,
+		TreeOptions options, Score_t alpha, const Score_t beta);
+
 	Score_t recurse_create_tree(
 		Move move, NodePointer & nptr,
 		Bitboard & board, int remaining,
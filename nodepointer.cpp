@@ -27,6 +27,24 @@ NodePointer::NodePointer(Node * node) {
 	this->mode = NODE_POINTER_NODE_MODE;
 }
 
+NodePointer::NodePointer(NodePointer && other) {
+	mode = other.mode;
+	capture = other.capture;
+	data = other.data;
+	other.mode = NODE_POINTER_SCORE_MODE;
+}
+
+NodePointer & NodePointer::operator =(NodePointer && other) {
+	if (this != &other) {
+		if (mode == NODE_POINTER_NODE_MODE) delete data.node;
+		mode = other.mode;
+		capture = other.capture;
+		data = other.data;
+		other.mode = NODE_POINTER_SCORE_MODE;
+	}
+	return *this;
+}
+
 NodePointer::~NodePointer() {
 	// check if a node has been allocated
 	if (mode == NODE_POINTER_NODE_MODE) delete data.node;
@@ -13,4 +13,57 @@
 #define NODE_MEMORY_ALLOCATION 1000000
 #define MAX_SEARCH_DEPTH 128
 
+// Plies taken off the search after a null move
+#define NULL_MOVE_REDUCTION 2
+
+// Lazy evaluation scores a leaf by its material alone when the material is
+// further than this outside the alpha-beta window. The rest of the evaluation
+// is within 5000 of the material in all but about 1 in 2000 positions.
+#define LAZY_EVAL_MARGIN 5000
+
+// Size of the material table, as a power of 2 entries of 16 bytes
+#define MATERIAL_HASH_BITS 12
+// Size of the pawn table, as a power of 2 entries of 24 bytes
+#define PAWN_HASH_BITS 13
+// Size of the evaluation cache, as a power of 2 entries of 8 bytes (0 for none).
+// Off because a probe that misses the processor cache costs more than the
+// evaluation it saves; 16 bits gives a hit rate of about 28% in the search.
+#define EVAL_CACHE_BITS 0
+
+// Count bits with the POPCNT instruction instead of arithmetic. Every x64
+// processor since about 2008 has it; GCC also needs -mpopcnt or -march.
+#define HARDWARE_POPCOUNT 1
+
+// Allow slider attack lookups to use PEXT when the processor supports BMI2.
+// Some processors implement PEXT in microcode, where magics are faster.
+#define SLIDER_ALLOW_PEXT 1
+
+// Allow batched attack generation to use AVX2 when the processor supports it
+#define BATCH_ALLOW_AVX2 1
+
+// Keep the squares attacked by each side for every ply in make, so that move
+// generation, king safety and other attack queries share one computation
+#define CACHE_ATTACK_MAPS 1
+
+// Keep the attacks of every piece across make and unmake, only recomputing the
+// pieces that a move affects, instead of looking up each piece when generating.
+// Off because the bookkeeping in make costs more than the lookups it saves.
+#define INCREMENTAL_ATTACKS 0
+
+// Copy the whole board, mailbox included, to the next ply in make, so that
+// unmake only has to step back a ply. Otherwise the mailbox is shared by all
+// plies and unmake puts back the squares that the move changed.
+// Off because copying three cache lines costs more than restoring two squares.
+// Cannot be used with INCREMENTAL_ATTACKS.
+#define COPY_MAKE 0
+
+#if COPY_MAKE && INCREMENTAL_ATTACKS
+#error "COPY_MAKE cannot be used with INCREMENTAL_ATTACKS"
+#endif
+
+// Entries in the perft hash table as a power of two (0 for no table),
+// and the number of perft threads (0 for one per processor)
+#define PERFT_HASH_BITS 20
+#define PERFT_THREADS 0
+
 #endif
\ No newline at end of file
@@ -0,0 +1,29 @@
+/*******************************************************************************
+* Deep Winkelman
+*
+* Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
+* 15 June 2017
+*
+* Implementation of the pawn table
+*/
+
+#include "pawntable.h"
+
+PawnTable::PawnTable() {
+	// Positions without pawns have a key of 0 and score nothing, so empty
+	// entries are already right for them and wrong for every other key
+	for (unsigned int i = 0; i < SIZE; i++) {
+		entries[i].key = 0;
+		entries[i].score = 0;
+		entries[i].attacks[0] = entries[i].attacks[1] = 0;
+	}
+	reset_stats();
+}
+
+double PawnTable::hit_rate() const {
+	return probes ? (double)hits / probes : 0;
+}
+
+void PawnTable::reset_stats() {
+	probes = hits = 0;
+}
\ No newline at end of file
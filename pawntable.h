@@ -0,0 +1,58 @@
+/*******************************************************************************
+* Deep Winkelman
+*
+* Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
+* 15 June 2017
+*
+* Cache of the scores of pawn structures.
+*
+* Most moves do not move or capture a pawn, so the pawn terms of a position
+* are nearly always the same as its parent's. They are kept by the pawn key
+* (the hash of the pawns alone) along with the squares the pawns attack.
+*/
+
+#ifndef DEEP_WINKELMAN_PAWNTABLE
+#define DEEP_WINKELMAN_PAWNTABLE
+
+#include "movetable.h"
+#include "score.h"
+#include "params.h"
+
+struct PawnEntry {
+	uint32_t key;
+	// Score of the pawn terms that depend only on the pawns, for the
+	// middlegame and the endgame (see make_score)
+	Score_t score;
+	// Squares attacked by white and black pawns
+	Bitmask_t attacks[2];
+};
+
+// Direct-mapped cache of pawn entries.
+// Each search thread should have its own.
+class PawnTable {
+protected:
+	const static unsigned int SIZE = 1 << PAWN_HASH_BITS;
+	PawnEntry entries[SIZE];
+
+public:
+	// Counts of probes and of probes that found their key
+	unsigned long long probes, hits;
+
+	PawnTable();
+
+	// The entry for a key, and whether it already holds that key.
+	// If not, the caller fills it in.
+	inline PawnEntry & probe(const uint32_t key, bool & found) {
+		PawnEntry & entry = entries[key & (SIZE - 1)];
+		found = entry.key == key;
+		probes++;
+		hits += found;
+		return entry;
+	}
+
+	// Fraction of probes that found their key since the last reset
+	double hit_rate() const;
+	void reset_stats();
+};
+
+#endif
\ No newline at end of file
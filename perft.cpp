@@ -0,0 +1,200 @@
+/*******************************************************************************
+* Deep Winkelman
+*
+* Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
+* 10 June 2017
+*
+* Implementation for perft, divide and the reference position benchmark.
+*/
+
+#include "perft.h"
+#include "fen.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+PerftTable::PerftTable(const unsigned int bits) {
+	if (bits == 0) {
+		entries = nullptr;
+		mask = 0;
+		return;
+	}
+	mask = (one << bits) - 1;
+	entries = new Entry[mask + 1];
+	for (uint64_t i = 0; i <= mask; i++) {
+		entries[i].check.store(0, std::memory_order_relaxed);
+		entries[i].nodes.store(0, std::memory_order_relaxed);
+	}
+}
+
+PerftTable::~PerftTable() {
+	delete[] entries;
+}
+
+Hash_t PerftTable::key(const BitboardData & data, const int depth) {
+	// mix in the depth (splitmix64 finalizer)
+	uint64_t state = (uint64_t)depth + 0x9e3779b97f4a7c15ULL;
+	state = (state ^ (state >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	state = (state ^ (state >> 27)) * 0x94d049bb133111ebULL;
+	return data.hash ^ state ^ (state >> 31);
+}
+
+bool PerftTable::probe(const BitboardData & data, const int depth, uint64_t & nodes) const {
+	if (!entries) return false;
+	const Hash_t k = key(data, depth);
+	const Entry & entry = entries[k & mask];
+	nodes = entry.nodes.load(std::memory_order_relaxed);
+	return (entry.check.load(std::memory_order_relaxed) ^ nodes) == k;
+}
+
+void PerftTable::store(const BitboardData & data, const int depth, const uint64_t nodes) {
+	if (!entries) return;
+	const Hash_t k = key(data, depth);
+	Entry & entry = entries[k & mask];
+	entry.check.store(k ^ nodes, std::memory_order_relaxed);
+	entry.nodes.store(nodes, std::memory_order_relaxed);
+}
+
+uint64_t perft(Bitboard & board, const int depth, PerftTable * table) {
+	if (depth <= 0) return 1;
+
+	uint64_t nodes;
+	if (table && depth > 1 && table->probe(board.current_data(), depth, nodes)) return nodes;
+
+	MoveBuffer<MAX_MOVES> moves;
+	board.get_moves(moves);
+	// bulk counting: the moves are legal, so the last ply does not need making
+	if (depth == 1) return moves.size();
+
+	nodes = 0;
+	for (const Move move : moves) {
+		board.make(move);
+		nodes += perft(board, depth - 1, table);
+		board.unmake();
+	}
+
+	if (table) table->store(board.current_data(), depth, nodes);
+	return nodes;
+}
+
+// Move in the coordinate notation used by other engines' divide output,
+// so that counts can be compared move by move
+static std::string coordinate_move(const Move move) {
+	std::string output;
+	Coord_t start = move.start(), end = move.end();
+	if (move.is_castling()) {
+		switch (move.castling_type()) {
+		case WHITE_OO:	start = 4;	end = 6;	break;
+		case WHITE_OOO:	start = 4;	end = 2;	break;
+		case BLACK_OO:	start = 60;	end = 62;	break;
+		case BLACK_OOO:	start = 60;	end = 58;	break;
+		}
+	}
+	output += (char)('a' + start % 8);
+	output += (char)('1' + start / 8);
+	output += (char)('a' + end % 8);
+	output += (char)('1' + end / 8);
+	if (move.is_promotion()) output += ".pnbrqk"[(move.promotion_piece() - 1) % 6 + 1];
+	return output;
+}
+
+// Count the leaf nodes below each root move, with threads taking the next
+// root move until there are none left
+static void perft_root(const Position & position, const int depth, const MoveBuffer<MAX_MOVES> & moves,
+	std::vector<uint64_t> & counts, PerftTable & table, unsigned int threads) {
+	if (threads == 0) threads = std::thread::hardware_concurrency();
+	if (threads == 0) threads = 1;
+
+	std::atomic<unsigned int> next(0);
+	auto worker = [&]() {
+		// each thread needs its own history
+		std::unique_ptr<Bitboard> board(new Bitboard(position));
+		for (unsigned int i = next++; i < moves.size(); i = next++) {
+			board->make(moves[i]);
+			counts[i] = perft(*board, depth - 1, &table);
+			board->unmake();
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (unsigned int i = 1; i < threads; i++) pool.push_back(std::thread(worker));
+	worker();
+	for (std::thread & thread : pool) thread.join();
+}
+
+uint64_t perft_divide(const Position & position, const int depth, std::ostream & os,
+	const unsigned int hash_bits, const unsigned int threads) {
+	MoveBuffer<MAX_MOVES> moves;
+	Bitboard(position).get_moves(moves);
+	std::vector<uint64_t> counts(moves.size());
+	PerftTable table(hash_bits);
+
+	std::chrono::time_point<std::chrono::steady_clock> start, end;
+	start = std::chrono::steady_clock::now();
+	perft_root(position, depth, moves, counts, table, threads);
+	end = std::chrono::steady_clock::now();
+	std::chrono::duration<double> dur = end - start;
+
+	uint64_t total = 0;
+	for (unsigned int i = 0; i < moves.size(); i++) {
+		os << coordinate_move(moves[i]) << ": " << counts[i] << '\n';
+		total += counts[i];
+	}
+	// with no moves, the root itself is the only node at depth 0
+	if (depth <= 0) total = 1;
+
+	os << "\nNodes searched: " << total << '\n';
+	os << "Time: " << dur.count() << " seconds (" << total / dur.count() / 1e6 << " Mnps)\n";
+	return total;
+}
+
+bool perft_benchmark(std::ostream & os, const unsigned int hash_bits, const unsigned int threads) {
+	// Standard positions that between them reach every kind of special move
+	static const struct {
+		const char * name;
+		const char * fen;
+		int depth;
+		uint64_t nodes;
+	} positions[] = {
+		{ "start",		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 6, 119060324 },
+		{ "kiwipete",	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5, 193690690 },
+		{ "position 3",	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 7, 178633661 },
+		{ "position 4",	"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292 },
+		{ "position 5",	"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, 89941194 },
+		{ "position 6",	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 5, 164075551 },
+	};
+
+	bool passed = true;
+	uint64_t total_nodes = 0;
+	double total_time = 0;
+	for (const auto & reference : positions) {
+		const Position position = parse_fen(reference.fen);
+		MoveBuffer<MAX_MOVES> moves;
+		Bitboard(position).get_moves(moves);
+		std::vector<uint64_t> counts(moves.size());
+		PerftTable table(hash_bits);
+
+		std::chrono::time_point<std::chrono::steady_clock> start, end;
+		start = std::chrono::steady_clock::now();
+		perft_root(position, reference.depth, moves, counts, table, threads);
+		end = std::chrono::steady_clock::now();
+		std::chrono::duration<double> dur = end - start;
+
+		uint64_t nodes = 0;
+		for (const uint64_t count : counts) nodes += count;
+		passed &= nodes == reference.nodes;
+		total_nodes += nodes;
+		total_time += dur.count();
+
+		os << (nodes == reference.nodes ? "PASSED " : "FAILED ") << reference.name
+			<< " depth " << reference.depth << ": " << nodes << " nodes (expected "
+			<< reference.nodes << ") in " << dur.count() << " seconds ("
+			<< nodes / dur.count() / 1e6 << " Mnps)\n";
+	}
+	os << "Total: " << total_nodes << " nodes in " << total_time << " seconds ("
+		<< total_nodes / total_time / 1e6 << " Mnps)\n";
+	return passed;
+}
\ No newline at end of file
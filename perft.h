@@ -0,0 +1,65 @@
+/*******************************************************************************
+* Deep Winkelman
+*
+* Copyright (c) 2017 by Daniel Winkelman <dwinkelman3@gmail.com>
+* 10 June 2017
+*
+* Performance test (perft): counting the leaf nodes of the legal move tree to a
+* fixed depth. Measures move generation and make/unmake on their own, without
+* the game tree, and checks them against known counts.
+*
+* The last ply is counted in bulk from the number of legal moves instead of
+* being made. Counts of subtrees can be kept in a hash table, and the moves at
+* the root can be split across threads.
+*/
+
+#ifndef DEEP_WINKELMAN_PERFT
+#define DEEP_WINKELMAN_PERFT
+
+#include <atomic>
+#include <iostream>
+
+#include "bitboard.h"
+
+// Lockless table of subtree counts, shared by all threads.
+// Each entry stores its key XORed with its count, so an entry that was torn by
+// two threads writing at once fails the key check instead of giving a wrong count.
+class PerftTable {
+protected:
+	struct Entry {
+		std::atomic<uint64_t> check;
+		std::atomic<uint64_t> nodes;
+	};
+	Entry * entries;
+	uint64_t mask;
+
+	// Key for a position and the depth left to search below it
+	static Hash_t key(const BitboardData & data, const int depth);
+
+public:
+	// Create with 2^bits entries (0 for no table)
+	PerftTable(const unsigned int bits);
+	~PerftTable();
+	PerftTable(const PerftTable &) = delete;
+	PerftTable & operator =(const PerftTable &) = delete;
+
+	bool probe(const BitboardData & data, const int depth, uint64_t & nodes) const;
+	void store(const BitboardData & data, const int depth, const uint64_t nodes);
+};
+
+// Number of leaf nodes at a depth below the position, using the table if given
+uint64_t perft(Bitboard & board, const int depth, PerftTable * table = nullptr);
+
+// Print the leaf nodes below each root move, then the total and the speed.
+// Root moves are shared among the threads (0 for one per processor),
+// which each search their own board made from the position.
+// Returns the total number of leaf nodes.
+uint64_t perft_divide(const Position & position, const int depth, std::ostream & os,
+	const unsigned int hash_bits = PERFT_HASH_BITS, const unsigned int threads = PERFT_THREADS);
+
+// Run perft on the standard reference positions, checking the counts and
+// printing the speed of each. Returns whether all of the counts were correct.
+bool perft_benchmark(std::ostream & os,
+	const unsigned int hash_bits = PERFT_HASH_BITS, const unsigned int threads = PERFT_THREADS);
+
+#endif
\ No newline at end of file
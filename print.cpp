@@ -83,8 +83,8 @@ std::ostream & operator <<(std::ostream & os, const Bitboard & bitboard) {
 	os << "+---+-----------------+\n";
 	/*os << "White Pieces:\n" << print_mask(bitboard.current_data().white);
 	os << "Black Pieces:\n" << print_mask(bitboard.current_data().black);
-	os << "White Pawns:\n" << print_mask(bitboard.current_data().wpawns);
-	os << "Black Pawns:\n" << print_mask(bitboard.current_data().bpawns);*/
+	os << "White Pawns:\n" << print_mask(bitboard.current_data().pieces(WHITE_PAWN));
+	os << "Black Pawns:\n" << print_mask(bitboard.current_data().pieces(BLACK_PAWN));*/
 	os << ((bitboard.current_data().color == WHITE) ? "White" : "Black") << " to move\n";
 	os << "Hash: " << std::hex << bitboard.current_data().hash << std::dec << '\n';
 	os << "Score: " << bitboard.score_level_1() << '\n';
@@ -100,8 +100,9 @@ std::ostream & operator <<(std::ostream & os, const Bitboard & bitboard) {
 	else os << "--- ";
 	os << '\n';
 	os << "En Passant: ";
-	if (bitboard.current_data().ep.is_null()) os << "---";
-	else os << bitboard.current_data().ep;
+	const Coord_t ep = bitboard.current_data().ep;
+	if (ep == NO_MOVE) os << "---";
+	else os << (char)('a' + ep % 8) << (char)('1' + ep / 8);
 	os << '\n';
 
 	return os;
@@ -10,6 +10,107 @@
 #include "bitboard.h"
 #include "util.h"
 
+#include <algorithm>
+#include <cstdlib>
+
+// Middlegame piece-square values for white pawns, knights, bishops, rooks,
+// queens and kings, laid out as the board is printed (rank 8 first, a-file on
+// the left). Black uses the same tables flipped vertically.
+static const Score_t WHITE_PIECE_SQUARES[6][64] = {
+	{
+		   0,    0,    0,    0,    0,    0,    0,    0,
+		 500,  500,  500,  500,  500,  500,  500,  500,
+		 100,  100,  200,  300,  300,  200,  100,  100,
+		  50,   50,  100,  250,  250,  100,   50,   50,
+		   0,    0,    0,  200,  200,    0,    0,    0,
+		  50,  -50, -100,    0,    0, -100,  -50,   50,
+		  50,  100,  100, -200, -200,  100,  100,   50,
+		   0,    0,    0,    0,    0,    0,    0,    0
+	},
+	{
+		-500, -400, -300, -300, -300, -300, -400, -500,
+		-400, -200,    0,    0,    0,    0, -200, -400,
+		-300,    0,  100,  150,  150,  100,    0, -300,
+		-300,   50,  150,  200,  200,  150,   50, -300,
+		-300,    0,  150,  200,  200,  150,    0, -300,
+		-300,   50,  100,  150,  150,  100,   50, -300,
+		-400, -200,    0,   50,   50,    0, -200, -400,
+		-500, -400, -300, -300, -300, -300, -400, -500
+	},
+	{
+		-200, -100, -100, -100, -100, -100, -100, -200,
+		-100,    0,    0,    0,    0,    0,    0, -100,
+		-100,    0,   50,  100,  100,   50,    0, -100,
+		-100,   50,   50,  100,  100,   50,   50, -100,
+		-100,    0,  100,  100,  100,  100,    0, -100,
+		-100,  100,  100,  100,  100,  100,  100, -100,
+		-100,   50,    0,    0,    0,    0,   50, -100,
+		-200, -100, -100, -100, -100, -100, -100, -200
+	},
+	{
+		   0,    0,    0,    0,    0,    0,    0,    0,
+		  50,  100,  100,  100,  100,  100,  100,   50,
+		 -50,    0,    0,    0,    0,    0,    0,  -50,
+		 -50,    0,    0,    0,    0,    0,    0,  -50,
+		 -50,    0,    0,    0,    0,    0,    0,  -50,
+		 -50,    0,    0,    0,    0,    0,    0,  -50,
+		 -50,    0,    0,    0,    0,    0,    0,  -50,
+		   0,    0,    0,   50,   50,    0,    0,    0
+	},
+	{
+		-200, -100, -100,  -50,  -50, -100, -100, -200,
+		-100,    0,    0,    0,    0,    0,    0, -100,
+		-100,    0,   50,   50,   50,   50,    0, -100,
+		 -50,    0,   50,   50,   50,   50,    0,  -50,
+		   0,    0,   50,   50,   50,   50,    0,  -50,
+		-100,   50,   50,   50,   50,   50,    0, -100,
+		-100,    0,   50,    0,    0,    0,    0, -100,
+		-200, -100, -100,  -50,  -50, -100, -100, -200
+	},
+	{
+		-300, -400, -400, -500, -500, -400, -400, -300,
+		-300, -400, -400, -500, -500, -400, -400, -300,
+		-300, -400, -400, -500, -500, -400, -400, -300,
+		-300, -400, -400, -500, -500, -400, -400, -300,
+		-200, -300, -300, -400, -400, -300, -300, -200,
+		-100, -200, -200, -200, -200, -200, -200, -100,
+		 200,  200,    0,    0,    0,    0,  200,  200,
+		 200,  300,  100,    0,    0,  100,  300,  200
+	}
+};
+
+// Endgame piece-square values for the white king, which should come to the
+// centre once there is little left to attack it. The other pieces use their
+// middlegame values.
+static const Score_t WHITE_KING_SQUARES_ENDGAME[64] = {
+	-500, -400, -300, -200, -200, -300, -400, -500,
+	-300, -200, -100,    0,    0, -100, -200, -300,
+	-300, -100,  200,  300,  300,  200, -100, -300,
+	-300, -100,  300,  400,  400,  300, -100, -300,
+	-300, -100,  300,  400,  400,  300, -100, -300,
+	-300, -100,  200,  300,  300,  200, -100, -300,
+	-300, -300,    0,    0,    0,    0, -300, -300,
+	-500, -300, -300, -300, -300, -300, -300, -500
+};
+
+ScoreParams::ScoreParams() {
+	for (int i = 0; i < 64; i++) {
+		PIECE_SQUARES[NO_PIECE][i] = 0;
+	}
+	for (int type = 0; type < 6; type++) {
+		for (int i = 0; i < 64; i++) {
+			// the table row for square i is its rank counted from rank 8
+			const int index = (7 - i / 8) * 8 + i % 8;
+			const Score_t mg = WHITE_PIECE_SQUARES[type][index];
+			const Score_t eg = (WHITE_PAWN + type == WHITE_KING) ? WHITE_KING_SQUARES_ENDGAME[index] : mg;
+			const Score_t value = make_score(mg, eg);
+			PIECE_SQUARES[WHITE_PAWN + type][i] = value;
+			// mirror for black: its square i is white's square i ^ 56
+			PIECE_SQUARES[BLACK_PAWN + type][i ^ 56] = -value;
+		}
+	}
+}
+
 Score_t Bitboard::score_level_0() const {
 	/**
 	* Considers only piece score
@@ -18,13 +119,52 @@ Score_t Bitboard::score_level_0() const {
 }
 
 Score_t Bitboard::score_level_1() const {
+	const Hash_t hash = history[depth].hash;
+	Score_t score;
+	if (eval_cache.probe(hash, score)) return score;
+	score = evaluate();
+	eval_cache.store(hash, score);
+	return score;
+}
+
+Score_t Bitboard::score_lazy(const Score_t alpha, const Score_t beta) const {
+	lazy_evaluations++;
+	const Score_t material = score_material();
+	if (material + LAZY_EVAL_MARGIN <= alpha || material - LAZY_EVAL_MARGIN >= beta) {
+		// endgames with their own evaluation can be far from the material
+		if (material_table.probe(history[depth].material_key, sparams).endgame == ENDGAME_NONE) {
+			lazy_cutoffs++;
+			return material;
+		}
+	}
+	return score_level_1();
+}
+
+Score_t Bitboard::evaluate() const {
 	/**
 	* Considers:
 	*	- piece score
+	*	- material imbalance and endgames with their own evaluation
+	*	- piece-square values
+	*	- mobility of pieces
 	*	- advancement of pawns
 	*	- connectivity of pawns
+	* Everything but the piece score is blended by the game phase.
 	*/
-	return (score_material() + score_pawn_structure());// *history[depth].color;
+	const BitboardData & data = history[depth];
+	const MaterialEntry & material = material_table.probe(data.material_key, sparams);
+	if (material.endgame == ENDGAME_DRAW) return SCORE_DRAW;
+	if (material.endgame == ENDGAME_KXK) return score_material() + score_kxk(material.strong_side);
+	const PawnEntry & pawns = pawn_entry();
+	// the terms are summed as middlegame/endgame pairs and blended once.
+	// The piece-square sum is unpacked on its own, since together with the
+	// rest it could overflow 16 bits.
+	const Score_t terms = material.imbalance
+		+ mobility<WHITE>(pawns.attacks[1]) + mobility<BLACK>(pawns.attacks[0])
+		+ pawns.score + score_blocked_pawns();
+	return score_material() + taper(
+		mg_value(data.positioning_score) + mg_value(terms),
+		eg_value(data.positioning_score) + eg_value(terms), data.phase);// *history[depth].color;
 }
 
 Score_t Bitboard::score_material() const {
@@ -40,14 +180,41 @@ Score_t Bitboard::score_pawn_structure() const {
 	 * Central control
 	**/
 
+	return taper(pawn_entry().score + score_blocked_pawns(), current_data().phase);
+}
+
+const PawnEntry & Bitboard::pawn_entry() const {
+	const BitboardData & data = current_data();
+	bool found;
+	PawnEntry & entry = pawn_table.probe(data.pawn_key, found);
+	if (!found) {
+		entry.key = data.pawn_key;
+		entry.score = score_pawns_only();
+		entry.attacks[0] = pawn_attacks<WHITE>(data.pieces(WHITE_PAWN));
+		entry.attacks[1] = pawn_attacks<BLACK>(data.pieces(BLACK_PAWN));
+	}
+	return entry;
+}
+
+Score_t Bitboard::score_blocked_pawns() const {
+	const BitboardData & data = current_data();
+	unsigned int w_blocked_pawns = move_manager.wp_moves.blocked_pawns(
+		data.pieces(WHITE_PAWN), data.white | data.black);
+	unsigned int b_blocked_pawns = move_manager.bp_moves.blocked_pawns(
+		data.pieces(BLACK_PAWN), data.white | data.black);
+	return sparams.PAWN_BLOCKED *
+		(signed)(w_blocked_pawns - b_blocked_pawns);
+}
+
+Score_t Bitboard::score_pawns_only() const {
 	Score_t output = 0;
 	const BitboardData & data = current_data();
 
 	const Bitmask_t center_mask = 0x0000c3c3c3c30000;
 
 	// Advancement
-	Bitmask_t w_rows = half_popcount(data.wpawns);
-	Bitmask_t b_rows = half_popcount(data.bpawns);
+	Bitmask_t w_rows = half_popcount(data.pieces(WHITE_PAWN));
+	Bitmask_t b_rows = half_popcount(data.pieces(BLACK_PAWN));
 	output +=
 		sparams.PAWN_RANK_2 * ((0xff & (w_rows >>  8)) - (0xff & (b_rows >> 48))),
 		sparams.PAWN_RANK_3 * ((0xff & (w_rows >> 16)) - (0xff & (b_rows >> 40))),
@@ -56,25 +223,18 @@ Score_t Bitboard::score_pawn_structure() const {
 		sparams.PAWN_RANK_6 * ((0xff & (w_rows >> 40)) - (0xff & (b_rows >> 16))),
 		sparams.PAWN_RANK_7 * ((0xff & (w_rows >> 48)) - (0xff & (b_rows >> 8)));
 	// Connectivity
-	unsigned int w_defended_pawns = move_manager.wp_moves.pieces_attacked(data.wpawns, data.wpawns);
-	unsigned int b_defended_pawns = move_manager.bp_moves.pieces_attacked(data.bpawns, data.bpawns);
+	unsigned int w_defended_pawns = move_manager.wp_moves.pieces_attacked(data.pieces(WHITE_PAWN), data.pieces(WHITE_PAWN));
+	unsigned int b_defended_pawns = move_manager.bp_moves.pieces_attacked(data.pieces(BLACK_PAWN), data.pieces(BLACK_PAWN));
 	output += sparams.PAWN_DEFENDING_PAWN *
 		(signed)(w_defended_pawns - b_defended_pawns);
 	// Doubled Pawns
-	unsigned int w_doubled_pawns = move_manager.wp_moves.doubled_pawns(data.wpawns);
-	unsigned int b_doubled_pawns = move_manager.bp_moves.doubled_pawns(data.bpawns);
+	unsigned int w_doubled_pawns = move_manager.wp_moves.doubled_pawns(data.pieces(WHITE_PAWN));
+	unsigned int b_doubled_pawns = move_manager.bp_moves.doubled_pawns(data.pieces(BLACK_PAWN));
 	output += sparams.PAWN_DOUBLED *
 		(signed)(w_doubled_pawns - b_doubled_pawns);
-	// Blocked Pawns
-	unsigned int w_blocked_pawns = move_manager.wp_moves.blocked_pawns(
-		data.wpawns, data.white | data.black);
-	unsigned int b_blocked_pawns = move_manager.bp_moves.blocked_pawns(
-		data.bpawns, data.white | data.black);
-	output += sparams.PAWN_BLOCKED * 
-		(signed)(w_blocked_pawns - b_blocked_pawns);
 	// Central Control
-	unsigned int w_center_squares = move_manager.wp_moves.square_control(data.wpawns, center_mask);
-	unsigned int b_center_squares = move_manager.bp_moves.square_control(data.bpawns, center_mask);
+	unsigned int w_center_squares = move_manager.wp_moves.square_control(data.pieces(WHITE_PAWN), center_mask);
+	unsigned int b_center_squares = move_manager.bp_moves.square_control(data.pieces(BLACK_PAWN), center_mask);
 	output += sparams.PAWN_CENTER_ATTACK *
 		(signed)(w_center_squares - b_center_squares);
 
@@ -83,21 +243,74 @@ Score_t Bitboard::score_pawn_structure() const {
 
 Score_t Bitboard::score_piece_position() const {
 	/**
-	 * Centralization of pieces
+	 * Mobility of pieces
 	**/
 
-	Score_t output = 0;
 	const BitboardData & data = current_data();
+	return taper(mobility<WHITE>(pawn_attacks<BLACK>(data.pieces(BLACK_PAWN)))
+		+ mobility<BLACK>(pawn_attacks<WHITE>(data.pieces(WHITE_PAWN))), data.phase);
+}
 
-	for (int i = 0; i < 64; i++) {
-		unsigned int n_moves =
-			((move_manager.*(move_manager.move_counters[squares[i]])))
-			(i, data.white, data.black);
-		sparams.PIECE_MOBILITY[squares[i]] * (signed)n_moves;
-			
-	}
+template<Color_t Us>
+Score_t Bitboard::mobility(const Bitmask_t enemy_pawn_attacks) const {
+	const BitboardData & data = current_data();
+	const Piece_t offset = (Us == WHITE) ? 0 : BLACK_PAWN - WHITE_PAWN;
+	const Bitmask_t occupancy = data.white | data.black;
+	const Bitmask_t own = (Us == WHITE) ? data.white : data.black;
 
-	return output;
+	// squares that hold a piece of the same side or are attacked by an enemy
+	// pawn are not counted
+	const Bitmask_t available = ~own & ~enemy_pawn_attacks;
+
+	// count the attacks of each kind of piece together, then weight them once
+	unsigned int knights = 0, bishops = 0, rooks = 0, queens = 0;
+	for (Bitmask_t b = data.pieces(WHITE_KNIGHT + offset); b; )
+		knights += popcount(move_manager.n_moves.masks[pop_lsb(b)] & available);
+	for (Bitmask_t b = data.pieces(WHITE_BISHOP + offset); b; )
+		bishops += popcount(move_manager.slider_moves.bishop_attacks(pop_lsb(b), occupancy) & available);
+	for (Bitmask_t b = data.pieces(WHITE_ROOK + offset); b; )
+		rooks += popcount(move_manager.slider_moves.rook_attacks(pop_lsb(b), occupancy) & available);
+	for (Bitmask_t b = data.pieces(WHITE_QUEEN + offset); b; )
+		queens += popcount(move_manager.slider_moves.queen_attacks(pop_lsb(b), occupancy) & available);
+	const Coord_t king = (Us == WHITE) ? data.white_king : data.black_king;
+	const unsigned int kings = popcount(move_manager.k_moves.masks[king] & available);
+
+	const Score_t * weights = sparams.PIECE_MOBILITY + offset;
+	return weights[WHITE_KNIGHT] * (signed)knights + weights[WHITE_BISHOP] * (signed)bishops
+		+ weights[WHITE_ROOK] * (signed)rooks + weights[WHITE_QUEEN] * (signed)queens
+		+ weights[WHITE_KING] * (signed)kings;
+}
+
+Score_t Bitboard::score_king_safety() const {
+	/**
+	 * Attacks on the squares around each king
+	**/
+
+	const BitboardData & data = current_data();
+
+	const Bitmask_t w_zone = move_manager.k_moves.masks[data.white_king] | (one << data.white_king);
+	const Bitmask_t b_zone = move_manager.k_moves.masks[data.black_king] | (one << data.black_king);
+	unsigned int w_attacked = popcount(w_zone & attacked_squares(BLACK));
+	unsigned int b_attacked = popcount(b_zone & attacked_squares(WHITE));
+
+	return taper(sparams.KING_ZONE_ATTACKED *
+		(signed)(w_attacked - b_attacked), data.phase);
+}
+
+Score_t Bitboard::score_kxk(const Color_t strong_side) const {
+	const BitboardData & data = current_data();
+	const Coord_t strong_king = (strong_side == WHITE) ? data.white_king : data.black_king;
+	const Coord_t weak_king = (strong_side == WHITE) ? data.black_king : data.white_king;
+
+	// steps from the centre, 0 to 6
+	const int weak_rank = weak_king / 8, weak_file = weak_king % 8;
+	const int to_edge = std::max(3 - weak_rank, weak_rank - 4) + std::max(3 - weak_file, weak_file - 4);
+	// distance between the kings in king moves, 1 to 7
+	const int kings_apart = std::max(std::abs(strong_king / 8 - weak_rank),
+		std::abs(strong_king % 8 - weak_file));
+
+	return (sparams.KXK_KING_TO_EDGE * to_edge + sparams.KXK_KINGS_CLOSE * (7 - kings_apart))
+		* ((strong_side == WHITE) ? 1 : -1);
 }
 
 Move_Rank_t Bitboard::move_rank(const Move move) {
@@ -21,8 +21,38 @@ typedef int32_t Move_Rank_t;
 #define SCORE_DRAW 0x0
 #define SCORE_INVALID 0x00cccccc
 
+// Phase of the game at the start, counting minor pieces as 1, rooks as 2
+// and queens as 4. Positional terms are blended from their middlegame value
+// at this phase to their endgame value at 0.
+#define PHASE_OPENING 24
+
+// A middlegame and an endgame score packed into one Score_t, the endgame score
+// in the upper 16 bits, so that both are added, subtracted and multiplied by
+// counts together. Each half must stay within 16 bits.
+constexpr Score_t make_score(const int mg, const int eg) {
+	return eg * 0x10000 + mg;
+}
+inline Score_t mg_value(const Score_t score) {
+	return (int16_t)(uint16_t)score;
+}
+inline Score_t eg_value(const Score_t score) {
+	return (score - mg_value(score)) / 0x10000;
+}
+
+// Blend a middlegame and an endgame score for a phase (above PHASE_OPENING
+// counts as PHASE_OPENING, which promotions can reach)
+inline Score_t taper(const Score_t mg, const Score_t eg, unsigned int phase) {
+	if (phase > PHASE_OPENING) phase = PHASE_OPENING;
+	return (mg * (signed)phase + eg * (signed)(PHASE_OPENING - phase)) / PHASE_OPENING;
+}
+inline Score_t taper(const Score_t score, const unsigned int phase) {
+	return taper(mg_value(score), eg_value(score), phase);
+}
+
 // Container for the scoring parameters to be used.
-// Scores are in thousands of a pawn.
+// Scores are in thousands of a pawn. Apart from the piece values and the
+// ENDGAME_KXK terms, which do not depend on the phase, they are made with
+// make_score from a middlegame and an endgame value.
 class ScoreParams {
 public:
 	// Values for each of the pieces.
@@ -30,29 +60,50 @@ public:
 		0, 1000, 3000, 3200, 5000, 9000, 2000000, -1000, -3000, -3200, -5000, -9000, -2000000
 	};
 
-	// Values for each of the moves of each piece
+	// Value of each piece on each square, from white's point of view for white
+	// pieces and black's (negated) for black pieces. Filled in from the tables
+	// in score.cpp. Kept as a running sum in make.
+	Score_t PIECE_SQUARES[13][64];
+
+	// Values for each square a piece attacks that does not hold a piece of
+	// its own side and is not attacked by an enemy pawn (pawns are not counted)
 	Score_t PIECE_MOBILITY[13] = {
-		0, 100, 120, 130, 140, 140, 50, -100, -120, -130, -140, -140, -50
+		0,
+		make_score(100, 80), make_score(120, 120), make_score(130, 160),
+		make_score(140, 100), make_score(140, 100), make_score(50, 150),
+		make_score(-100, -80), make_score(-120, -120), make_score(-130, -160),
+		make_score(-140, -100), make_score(-140, -100), make_score(-50, -150)
 	};
 
+	// Score for having two or more bishops
+	Score_t BISHOP_PAIR = make_score(500, 700);
+	// Score for each step the bare king is from the centre in ENDGAME_KXK
+	Score_t KXK_KING_TO_EDGE = 200;
+	// Score for each step the kings are closer than 7 apart in ENDGAME_KXK
+	Score_t KXK_KINGS_CLOSE = 100;
+
 	// Score for each pawn defended by another pawn
-	Score_t PAWN_DEFENDING_PAWN = 121;
+	Score_t PAWN_DEFENDING_PAWN = make_score(121, 150);
 	// Score for each piece defended by a pawn
-	Score_t PAWN_DEFENDING_PIECE = 85;
+	Score_t PAWN_DEFENDING_PIECE = make_score(85, 60);
 	// Score for each pawn blocked by another piece
-	Score_t PAWN_BLOCKED = -63;
+	Score_t PAWN_BLOCKED = make_score(-63, -120);
 	// Score for each doubled pawn
-	Score_t PAWN_DOUBLED = -200;
+	Score_t PAWN_DOUBLED = make_score(-200, -350);
 	// Score for each attack into the center 16 squares
-	Score_t PAWN_CENTER_ATTACK = 52;
+	Score_t PAWN_CENTER_ATTACK = make_score(52, 20);
+	// Score for each square next to the king (or under it) attacked by the enemy
+	Score_t KING_ZONE_ATTACKED = make_score(-90, -30);
 	// Score for each pawn on each rank
 	Score_t
-		PAWN_RANK_2 = 40,
-		PAWN_RANK_3 = 78,
-		PAWN_RANK_4 = 105,
-		PAWN_RANK_5 = 150,
-		PAWN_RANK_6 = 200,
-		PAWN_RANK_7 = 400;
+		PAWN_RANK_2 = make_score(40, 60),
+		PAWN_RANK_3 = make_score(78, 120),
+		PAWN_RANK_4 = make_score(105, 200),
+		PAWN_RANK_5 = make_score(150, 350),
+		PAWN_RANK_6 = make_score(200, 600),
+		PAWN_RANK_7 = make_score(400, 1000);
+
+	ScoreParams();
 };
 
 #endif
\ No newline at end of file
@@ -71,9 +71,8 @@ public:
 	int counter = 0;
 	
 public:
-	// Create a game tree from a bitboard
-	GameTree(Bitboard board) {
-		this->board = board;
+	// Create a game tree from a position
+	GameTree(const Position & position) : board(position) {
 		root = new Node();
 		root->color = board.current_data().color;
 		Node::ttable.insert(board.current_data().hash, root);
@@ -93,11 +92,14 @@ public:
 			0, 0);
 	}
 
-	void alpha_beta_tree(const int depth) {
-		root->create_tree(board, depth,
-			Node::TreeOptions::PRESORT_MOVES,
+	void alpha_beta_tree(const int depth, const bool null_move_pruning = false,
+		const bool lazy_evaluation = false) {
+		int options = Node::PRESORT_MOVES;
+		if (null_move_pruning) options |= Node::NULL_MOVE_PRUNING;
+		if (lazy_evaluation) options |= Node::LAZY_EVALUATION;
+		root->create_tree(board, depth, (Node::TreeOptions)options,
 			&Bitboard::move_rank,
-			SCORE_BLACK_WIN, 6000);
+			SCORE_BLACK_WIN, SCORE_WHITE_WIN);
 	}
 
 	void queue_deeping(const int nodes) {
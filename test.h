@@ -13,8 +13,30 @@
 #include <iostream>
 #include <chrono>
 #include <ctime>
+#include <random>
+#include <cstdlib>
+#include <new>
 
+#include "batch.h"
+#include "debug.h"
 #include "search.h"
+#include "fen.h"
+
+#if COUNT_ALLOCATIONS
+// Replace the global allocator to count every heap allocation
+unsigned long long allocation_count = 0;
+void * operator new(std::size_t size) {
+	allocation_count++;
+	void * ptr = std::malloc(size ? size : 1);
+	if (!ptr) throw std::bad_alloc();
+	return ptr;
+}
+void operator delete(void * ptr) noexcept {
+	std::free(ptr);
+}
+#else
+unsigned long long allocation_count = 0;
+#endif
 
 double time_test(void(*function)()) {
 	std::chrono::time_point<std::chrono::system_clock> start, end;
@@ -36,8 +58,7 @@ void test_basic_make_unmake() {
 }
 
 void _test_tree_gen_benchmark_function() {
-	Bitboard board;
-	GameTree tree(board);
+	GameTree tree((Position()));
 	tree.uniform_tree(5);
 	std::cout << tree.counter << " parent nodes generated ("
 		<< tree.root->counter << " nodes total)\n";
@@ -46,6 +67,521 @@ void test_tree_gen_benchmark() {
 	time_test(_test_tree_gen_benchmark_function);
 }
 
+// Compare queen move counting with the line tables (four lookups) against the
+// slider table (one lookup) using magics and PEXT.
+void test_slider_benchmark() {
+	const int n_positions = 1 << 16, n_repeats = 64;
+	std::mt19937_64 gen(2017);
+	std::vector<Coord_t> coords(n_positions);
+	std::vector<Bitmask_t> friendly(n_positions), enemy(n_positions);
+	for (int i = 0; i < n_positions; i++) {
+		coords[i] = gen() % 64;
+		Bitmask_t occupancy = gen() & gen();
+		Bitmask_t side = gen();
+		friendly[i] = (occupancy & side) | (one << coords[i]);
+		enemy[i] = occupancy & ~side & ~(one << coords[i]);
+	}
+
+	// tables are too large for the stack
+	HMoveTable * h_moves = new HMoveTable();
+	VMoveTable * v_moves = new VMoveTable();
+	D1MoveTable * d1_moves = new D1MoveTable();
+	D2MoveTable * d2_moves = new D2MoveTable();
+	SliderMoveTable * magic_moves = new SliderMoveTable(false);
+	SliderMoveTable * pext_moves = new SliderMoveTable(true);
+
+	std::chrono::time_point<std::chrono::system_clock> start, end;
+	std::chrono::duration<double> dur;
+	double lookups = (double)n_positions * n_repeats;
+
+	// line tables
+	uint64_t line_checksum = 0;
+	start = std::chrono::system_clock::now();
+	for (int r = 0; r < n_repeats; r++) {
+		for (int i = 0; i < n_positions; i++) {
+			line_checksum +=
+				h_moves->get_movelist(coords[i], friendly[i], enemy[i]).n_coords +
+				v_moves->get_movelist(coords[i], friendly[i], enemy[i]).n_coords +
+				d1_moves->get_movelist(coords[i], friendly[i], enemy[i]).n_coords +
+				d2_moves->get_movelist(coords[i], friendly[i], enemy[i]).n_coords;
+		}
+	}
+	end = std::chrono::system_clock::now();
+	dur = end - start;
+	double line_time = dur.count();
+	std::cout << "Line tables:   " << line_time * 1e9 / lookups << " ns per queen (checksum "
+		<< line_checksum << ")\n";
+
+	// slider table with each indexing method
+	SliderMoveTable * tables[2] = { magic_moves, pext_moves };
+	for (SliderMoveTable * table : tables) {
+		uint64_t checksum = 0;
+		start = std::chrono::system_clock::now();
+		for (int r = 0; r < n_repeats; r++) {
+			for (int i = 0; i < n_positions; i++) {
+				checksum += popcount(
+					table->queen_attacks(coords[i], friendly[i] | enemy[i]) & ~friendly[i]);
+			}
+		}
+		end = std::chrono::system_clock::now();
+		dur = end - start;
+		std::cout << (table->is_using_pext() ? "Slider (PEXT): " : "Slider (magic):")
+			<< dur.count() * 1e9 / lookups << " ns per queen ("
+			<< line_time / dur.count() << "x, checksum " << checksum << ")\n";
+	}
+
+	delete h_moves;
+	delete v_moves;
+	delete d1_moves;
+	delete d2_moves;
+	delete magic_moves;
+	delete pext_moves;
+}
+
+
+// Walk the move tree with each get_moves API, counting nodes and allocations
+unsigned long long _walk_vector_moves(Bitboard & board, const int depth) {
+	std::vector<Move> moves = board.get_moves();
+	if (depth == 1) return moves.size();
+	unsigned long long nodes = 0;
+	for (Move move : moves) {
+		board.make(move);
+		nodes += _walk_vector_moves(board, depth - 1);
+		board.unmake();
+	}
+	return nodes;
+}
+unsigned long long _walk_buffer_moves(Bitboard & board, const int depth) {
+	MoveBuffer<MAX_MOVES> moves;
+	board.get_moves(moves);
+	if (depth == 1) return moves.size();
+	unsigned long long nodes = 0;
+	for (Move move : moves) {
+		board.make(move);
+		nodes += _walk_buffer_moves(board, depth - 1);
+		board.unmake();
+	}
+	return nodes;
+}
+
+// Compare heap allocations per node of the vector and buffer move APIs
+void test_move_buffer_benchmark() {
+	if (!COUNT_ALLOCATIONS) std::cout << "Allocation counting is disabled in debug.h\n";
+
+	const char * fens[2] = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"
+	};
+	for (const char * fen : fens) {
+		Bitboard board = parse_fen(fen);
+		std::cout << fen << "\n";
+
+		unsigned long long(*walks[2])(Bitboard &, const int) = {
+			_walk_vector_moves, _walk_buffer_moves };
+		const char * names[2] = { "std::vector<Move>: ", "MoveBuffer<256>:   " };
+		for (int i = 0; i < 2; i++) {
+			// every node of the walk except the leaves calls get_moves
+			unsigned long long parents = _walk_buffer_moves(board, 3) + _walk_buffer_moves(board, 2) +
+				_walk_buffer_moves(board, 1) + 1;
+			unsigned long long allocations = allocation_count;
+			std::chrono::time_point<std::chrono::system_clock> start, end;
+			start = std::chrono::system_clock::now();
+			unsigned long long nodes = walks[i](board, 4);
+			end = std::chrono::system_clock::now();
+			allocations = allocation_count - allocations;
+			std::chrono::duration<double> dur = end - start;
+			std::cout << names[i] << nodes << " leaves, " << (double)allocations / parents
+				<< " allocations per node, " << dur.count() << " seconds\n";
+		}
+
+		// populate still allocates the children of the node, but not the move list
+		Node node(board.current_data().color, 0);
+		unsigned long long allocations = allocation_count;
+		node.populate(board, &Bitboard::score_level_1);
+		std::cout << "Node::populate:    " << allocation_count - allocations
+			<< " allocations (children only)\n\n";
+	}
+}
+// Walk the move tree, running a generator repeatedly at each node it applies to
+typedef void(*_GeneratorTest)(const Bitboard &, MoveBuffer<MAX_MOVES> &);
+unsigned long long _walk_generator(Bitboard & board, const int depth,
+	_GeneratorTest generator, const bool only_in_check, const int repeats) {
+	MoveBuffer<MAX_MOVES> moves;
+	board.get_moves(moves);
+	unsigned long long checksum = 0;
+	if (generator && (!only_in_check || board.in_check())) {
+		for (int i = 0; i < repeats; i++) {
+			MoveBuffer<MAX_MOVES> output;
+			generator(board, output);
+			checksum += output.size();
+		}
+	}
+	if (depth > 1) {
+		for (Move move : moves) {
+			board.make(move);
+			checksum += _walk_generator(board, depth - 1, generator, only_in_check, repeats);
+			board.unmake();
+		}
+	}
+	return checksum;
+}
+
+// Compare full move generation with the capture and evasion generators
+void test_tactical_generation_benchmark() {
+	// nodes in check are rare, so run the generators many more times there
+	const int repeats = 16, check_repeats = 1024;
+	const char * fens[2] = {
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+	};
+	_GeneratorTest full = [](const Bitboard & board, MoveBuffer<MAX_MOVES> & output) {
+		board.get_moves(output); };
+	_GeneratorTest captures = [](const Bitboard & board, MoveBuffer<MAX_MOVES> & output) {
+		board.generate_captures(output); };
+	_GeneratorTest evasions = [](const Bitboard & board, MoveBuffer<MAX_MOVES> & output) {
+		board.generate_evasions(output); };
+
+	for (const char * fen : fens) {
+		Bitboard board = parse_fen(fen);
+		std::cout << fen << "\n";
+
+		// time of the walk itself, to be taken out of each measurement
+		std::chrono::time_point<std::chrono::system_clock> start, end;
+		std::chrono::duration<double> dur;
+		double times[5];
+		struct { _GeneratorTest generator; bool only_in_check; } runs[5] = {
+			{ nullptr, false }, { full, false }, { captures, false },
+			{ full, true }, { evasions, true } };
+		for (int i = 0; i < 5; i++) {
+			start = std::chrono::system_clock::now();
+			_walk_generator(board, 4, runs[i].generator, runs[i].only_in_check,
+				runs[i].only_in_check ? check_repeats : repeats);
+			end = std::chrono::system_clock::now();
+			dur = end - start;
+			times[i] = dur.count() - (i ? times[0] : 0);
+		}
+		std::cout << "All nodes:      full " << times[1] << " s, captures " << times[2]
+			<< " s (" << times[1] / times[2] << "x)\n";
+		std::cout << "Nodes in check: full " << times[3] << " s, evasions " << times[4]
+			<< " s (" << times[3] / times[4] << "x)\n\n";
+	}
+}
+// Collect every position in the move tree, with the attack maps and mobility
+// score of the board itself to check the batched versions against
+void _collect_positions(Bitboard & board, const int depth, std::vector<BitboardData> & positions,
+	std::vector<Bitmask_t> & white_attacks, std::vector<Score_t> & mobility) {
+	positions.push_back(board.current_data());
+	white_attacks.push_back(board.attacked_squares(WHITE));
+	mobility.push_back(board.score_piece_position());
+	if (depth == 0) return;
+	MoveBuffer<MAX_MOVES> moves;
+	board.get_moves(moves);
+	for (Move move : moves) {
+		board.make(move);
+		_collect_positions(board, depth - 1, positions, white_attacks, mobility);
+		board.unmake();
+	}
+}
+
+// Squares attacked by white in a position, one piece at a time with table lookups
+Bitmask_t _lookup_white_attacks(const SliderMoveTable & sliders, const BitboardData & data) {
+	const Bitmask_t occupancy = data.white | data.black;
+	Bitmask_t attacked = MoveManager::wp_moves.attacks(data.pieces(WHITE_PAWN))
+		| MoveManager::k_moves.masks[data.white_king];
+	for (Bitmask_t b = data.pieces(WHITE_KNIGHT); b; ) attacked |= MoveManager::n_moves.masks[pop_lsb(b)];
+	for (Bitmask_t b = data.pieces(WHITE_BISHOP) | data.pieces(WHITE_QUEEN); b; )
+		attacked |= sliders.bishop_attacks(pop_lsb(b), occupancy);
+	for (Bitmask_t b = data.pieces(WHITE_ROOK) | data.pieces(WHITE_QUEEN); b; )
+		attacked |= sliders.rook_attacks(pop_lsb(b), occupancy);
+	return attacked;
+}
+
+// Mobility score of a position, one piece at a time with table lookups
+Score_t _lookup_mobility(const SliderMoveTable & sliders, const BitboardData & data,
+	const ScoreParams & sparams) {
+	const Bitmask_t occupancy = data.white | data.black;
+	Score_t score = 0;
+	for (int piece = WHITE_KNIGHT; piece <= BLACK_KING; piece++) {
+		if (piece == BLACK_PAWN) continue;
+		const Bitmask_t own = (piece < BLACK_PAWN) ?
+			data.white | MoveManager::bp_moves.attacks(data.pieces(BLACK_PAWN)) :
+			data.black | MoveManager::wp_moves.attacks(data.pieces(WHITE_PAWN));
+		for (Bitmask_t b = data.pieces(piece); b; ) {
+			Coord_t i = pop_lsb(b);
+			Bitmask_t moves;
+			switch (piece) {
+			case WHITE_KNIGHT: case BLACK_KNIGHT: moves = MoveManager::n_moves.masks[i] & ~own; break;
+			case WHITE_BISHOP: case BLACK_BISHOP: moves = sliders.bishop_attacks(i, occupancy) & ~own; break;
+			case WHITE_ROOK: case BLACK_ROOK: moves = sliders.rook_attacks(i, occupancy) & ~own; break;
+			case WHITE_QUEEN: case BLACK_QUEEN: moves = sliders.queen_attacks(i, occupancy) & ~own; break;
+			default: moves = MoveManager::k_moves.masks[i] & ~own; break;
+			}
+			score += sparams.PIECE_MOBILITY[piece] * (signed)popcount(moves);
+		}
+	}
+	return taper(score, data.phase);
+}
+
+// Compare attack maps and mobility for many positions, one at a time with
+// table lookups against batches with and without AVX2
+void test_batch_attacks_benchmark() {
+	std::vector<BitboardData> positions;
+	std::vector<Bitmask_t> white_attacks;
+	std::vector<Score_t> mobility;
+	Bitboard board = parse_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+	_collect_positions(board, 3, positions, white_attacks, mobility);
+	const unsigned int n = positions.size();
+	const int n_repeats = 16;
+	std::vector<const BitboardData *> pointers(n);
+	for (unsigned int i = 0; i < n; i++) pointers[i] = &positions[i];
+	std::cout << n << " positions\n";
+
+	std::chrono::time_point<std::chrono::system_clock> start, end;
+	std::chrono::duration<double> dur;
+	ScoreParams sparams;
+
+	// one position at a time
+	SliderMoveTable * sliders = new SliderMoveTable();
+	std::vector<Bitmask_t> attacks(n);
+	start = std::chrono::system_clock::now();
+	for (int r = 0; r < n_repeats; r++) {
+		for (unsigned int i = 0; i < n; i++) attacks[i] = _lookup_white_attacks(*sliders, positions[i]);
+	}
+	end = std::chrono::system_clock::now();
+	dur = end - start;
+	const double lookup_time = dur.count();
+	bool correct = attacks == white_attacks;
+	std::cout << "Lookups:         " << lookup_time * 1e9 / n / n_repeats << " ns per attack map ("
+		<< (correct ? "correct" : "WRONG") << ")\n";
+
+	std::vector<Score_t> scores(n);
+	start = std::chrono::system_clock::now();
+	for (int r = 0; r < n_repeats; r++) {
+		for (unsigned int i = 0; i < n; i++) scores[i] = _lookup_mobility(*sliders, positions[i], sparams);
+	}
+	end = std::chrono::system_clock::now();
+	dur = end - start;
+	const double lookup_mobility_time = dur.count();
+	correct = scores == mobility;
+	std::cout << "Lookups:         " << lookup_mobility_time * 1e9 / n / n_repeats << " ns per mobility score ("
+		<< (correct ? "correct" : "WRONG") << ")\n";
+	delete sliders;
+
+	AttackBatch batches[2] = { AttackBatch(false), AttackBatch(true) };
+	for (const AttackBatch & batch : batches) {
+		const char * name = batch.is_using_avx2() ? "Batch (AVX2):    " : "Batch (scalar):  ";
+
+		start = std::chrono::system_clock::now();
+		for (int r = 0; r < n_repeats; r++) batch.attacked_squares(pointers.data(), n, WHITE, attacks.data());
+		end = std::chrono::system_clock::now();
+		dur = end - start;
+		correct = attacks == white_attacks;
+		std::cout << name << dur.count() * 1e9 / n / n_repeats << " ns per attack map ("
+			<< lookup_time / dur.count() << "x, " << (correct ? "correct" : "WRONG") << ")\n";
+
+		start = std::chrono::system_clock::now();
+		for (int r = 0; r < n_repeats; r++) batch.score_piece_position(pointers.data(), n, sparams, scores.data());
+		end = std::chrono::system_clock::now();
+		dur = end - start;
+		correct = scores == mobility;
+		std::cout << name << dur.count() * 1e9 / n / n_repeats << " ns per mobility score ("
+			<< lookup_mobility_time / dur.count() << "x, " << (correct ? "correct" : "WRONG") << ")\n";
+	}
+}
+
+
+// Repeat every make/unmake pair in the move tree, counting the squares of the
+// mailbox that each pair changes
+unsigned long long _walk_make_unmake(Bitboard & board, const int depth, const int repeats,
+	unsigned long long & squares) {
+	MoveBuffer<MAX_MOVES> moves;
+	board.get_moves(moves);
+	unsigned long long pairs = 0;
+	for (Move move : moves) {
+		for (int i = 0; i < repeats; i++) {
+			board.make(move);
+			board.unmake();
+		}
+		pairs += repeats;
+		// castling moves two pieces and en passant goes through the captured square
+		squares += repeats * ((move.is_castling() || move.is_en_passant()) ? 4 : 2);
+		if (depth > 1) {
+			board.make(move);
+			pairs += _walk_make_unmake(board, depth - 1, repeats, squares);
+			board.unmake();
+		}
+	}
+	return pairs;
+}
+
+// Time make/unmake pairs and estimate the memory each pair touches.
+// Make reads the whole parent data and writes the whole child data. Without
+// COPY_MAKE it also writes the move records and the changed squares, and
+// unmake reads the records back and restores the squares.
+void test_make_unmake_benchmark() {
+	const int repeats = 16;
+	const char * fens[2] = {
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+	};
+	const unsigned int data_size = sizeof(BitboardData);
+	std::cout << "BitboardData: " << data_size << " bytes (" << (data_size + 63) / 64
+		<< " cache lines), " << (COPY_MAKE ? "copy-make\n" : "make/unmake\n");
 
+	for (const char * fen : fens) {
+		Bitboard board = parse_fen(fen);
+		unsigned long long squares = 0;
+		std::chrono::time_point<std::chrono::system_clock> start, end;
+		start = std::chrono::system_clock::now();
+		unsigned long long pairs = _walk_make_unmake(board, 3, repeats, squares);
+		end = std::chrono::system_clock::now();
+		std::chrono::duration<double> dur = end - start;
+
+		// both data are touched in full by make; the move records are written
+		// by make and read by unmake, and each square is written by both
+		double bytes = 2.0 * data_size;
+		if (!COPY_MAKE) bytes += 2.0 * squares / pairs;
+		std::cout << fen << "\n" << pairs << " pairs, " << dur.count() * 1e9 / pairs
+			<< " ns per pair, " << bytes << " bytes touched per pair\n";
+	}
+}
+
+// Walk the move tree, calling a scoring function several times at every node
+Score_t _walk_score(Bitboard & board, const int depth, const int repeats,
+	Bitboard::ScoreFunction function, unsigned long long & calls) {
+	Score_t total = 0;
+	for (int i = 0; i < repeats; i++) total += (board.*function)();
+	calls += repeats;
+	if (depth == 0) return total;
+	MoveBuffer<MAX_MOVES> moves;
+	board.get_moves(moves);
+	for (Move move : moves) {
+		board.make(move);
+		total += _walk_score(board, depth - 1, repeats, function, calls);
+		board.unmake();
+	}
+	return total;
+}
+
+// Time the scoring functions at every position of a move tree.
+// score_level_0 only reads a field, so its time is the cost of the walk,
+// which is taken off the others. score_level_1 is evaluate with the cache,
+// which the repeats at each position hit.
+void test_evaluation_benchmark() {
+	const int depth = 3, repeats = 8;
+	const char * fens[2] = {
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"1rb2rk1/1pqn1p1p/2pN2p1/p1N2P2/Pn1QP3/1P5P/4B1P1/2R2RK1 w - - 1 27"
+	};
+	struct {
+		const char * name;
+		Bitboard::ScoreFunction function;
+	} functions[4] = {
+		{ "score_level_0:        ", &Bitboard::score_level_0 },
+		{ "score_piece_position: ", &Bitboard::score_piece_position },
+		{ "evaluate:             ", &Bitboard::evaluate },
+		{ "score_level_1:        ", &Bitboard::score_level_1 }
+	};
+
+	for (const char * fen : fens) {
+		std::cout << fen << "\n";
+		double walk_time = 0;
+		for (auto & f : functions) {
+			Bitboard board = parse_fen(fen);
+			unsigned long long calls = 0;
+			std::chrono::time_point<std::chrono::system_clock> start, end;
+			start = std::chrono::system_clock::now();
+			Score_t total = _walk_score(board, depth, repeats, f.function, calls);
+			end = std::chrono::system_clock::now();
+			std::chrono::duration<double> dur = end - start;
+			if (f.function == &Bitboard::score_level_0) {
+				walk_time = dur.count();
+				std::cout << f.name << calls << " calls, " << walk_time * 1e9 / calls
+					<< " ns per call with the walk\n";
+				continue;
+			}
+
+			const double ns = (dur.count() - walk_time) * 1e9 / calls;
+			std::cout << f.name << calls << " calls, " << ns << " ns per call, "
+				<< 1e3 / ns << " M evals per second (total " << total << ")\n";
+		}
+	}
+}
+
+// Compare alpha-beta searches with and without null move pruning.
+// The transposition table and the killers are cleared before each search so
+// that neither search finds nodes or move orders left by the other.
+void test_null_move_benchmark() {
+	const int depth = 5;
+	const char * fens[4] = {
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"1rb2rk1/1pqn1p1p/2pN2p1/p1N2P2/Pn1QP3/1P5P/4B1P1/2R2RK1 w - - 1 27",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+	};
+
+	for (const char * fen : fens) {
+		std::cout << fen << "\n";
+		for (bool null_move : { false, true }) {
+			Node::ttable.clear();
+			Node::clear_killers();
+			Node::searched_nodes = 0;
+			Bitboard::get_pawn_table().reset_stats();
+			Bitboard::get_eval_cache().clear();
+			GameTree tree(parse_fen(fen));
+
+			std::chrono::time_point<std::chrono::system_clock> start, end;
+			start = std::chrono::system_clock::now();
+			tree.alpha_beta_tree(depth, null_move);
+			end = std::chrono::system_clock::now();
+			std::chrono::duration<double> dur = end - start;
+
+			std::cout << (null_move ? "null move: " : "full:      ") << Node::searched_nodes
+				<< " nodes, " << dur.count() << " seconds, score " << tree.root->score()
+				<< ", best " << tree.root->best_node()->move << ", pawn table hit rate "
+				<< Bitboard::get_pawn_table().hit_rate() * 100 << "%, evaluation cache hits "
+				<< Bitboard::get_eval_cache().get_hits() << "\n";
+		}
+	}
+}
+
+// Compare alpha-beta searches with and without lazy evaluation, both with null
+// move pruning, and count how many leaves were scored by material alone
+void test_lazy_evaluation_benchmark() {
+	const int depth = 5;
+	const char * fens[4] = {
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"1rb2rk1/1pqn1p1p/2pN2p1/p1N2P2/Pn1QP3/1P5P/4B1P1/2R2RK1 w - - 1 27",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+	};
+
+	for (const char * fen : fens) {
+		std::cout << fen << "\n";
+		for (bool lazy : { false, true }) {
+			Node::ttable.clear();
+			Node::clear_killers();
+			Node::searched_nodes = 0;
+			Bitboard::lazy_evaluations = Bitboard::lazy_cutoffs = 0;
+			Bitboard::get_eval_cache().clear();
+			GameTree tree(parse_fen(fen));
+
+			std::chrono::time_point<std::chrono::system_clock> start, end;
+			start = std::chrono::system_clock::now();
+			tree.alpha_beta_tree(depth, true, lazy);
+			end = std::chrono::system_clock::now();
+			std::chrono::duration<double> dur = end - start;
+
+			std::cout << (lazy ? "lazy: " : "full: ") << Node::searched_nodes
+				<< " nodes, " << dur.count() << " seconds, score " << tree.root->score()
+				<< ", best " << tree.root->best_node()->move;
+			if (lazy) {
+				std::cout << ", " << Bitboard::lazy_cutoffs << " of " << Bitboard::lazy_evaluations
+					<< " lazy evaluations by material alone";
+			}
+			std::cout << "\n";
+		}
+	}
+}
 
 #endif
\ No newline at end of file
@@ -11,6 +11,10 @@
 #include "transposition.h"
 
 TranspositionTable::TranspositionTable() {
+	clear();
+}
+
+void TranspositionTable::clear() {
 	for (int i = 0; i < n_pools; i++) {
 		bst[i] = BST<Hash_t, Node *>(0x8000000000000000);
 	}
@@ -23,7 +27,7 @@ void TranspositionTable::insert(const Hash_t hash, Node * node) {
 }
 
 Node * TranspositionTable::get(const Hash_t hash) const {
-	static bool exists;
+	bool exists;
 	Node * node = bst[hash & pool_mask].get_if_exists(hash, &exists);
 	return node;
 }
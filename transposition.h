@@ -34,6 +34,8 @@ public:
 	void set(const Hash_t hash, Node * node);
 	void remove(const Hash_t hash);
 	bool exists(const Hash_t hash) const;
+	// Forget all nodes, e.g. before searching a new position
+	void clear();
 };
 
 #endif
\ No newline at end of file
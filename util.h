@@ -8,16 +8,38 @@
 */
 
 #ifndef DEEP_WINKELMAN_UTIL
-#define DEEP_WINKELMAN_BITBOARD
+#define DEEP_WINKELMAN_UTIL
 
 #include <stdint.h>
 #include <vector>
 
+#include "params.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// PEXT is only available on 64-bit x86 processors with BMI2.
+// Whether the processor running the program has it must be checked at runtime.
+#if defined(_M_X64) || defined(__x86_64__)
+#define PEXT_AVAILABLE 1
+#else
+#define PEXT_AVAILABLE 0
+#endif
+
 inline unsigned int popcount(uint64_t w) {
+#if HARDWARE_POPCOUNT && defined(_MSC_VER) && defined(_M_X64)
+	return (unsigned int)__popcnt64(w);
+#elif HARDWARE_POPCOUNT && defined(__GNUC__) && defined(__POPCNT__)
+	return (unsigned int)__builtin_popcountll(w);
+#else
 	w -= (w >> 1) & 0x5555555555555555ULL;
 	w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
 	w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
-	return unsigned int((w * 0x0101010101010101ULL) >> 56);
+	return (unsigned int)((w * 0x0101010101010101ULL) >> 56);
+#endif
 }
 
 inline unsigned int popcount_max15(uint64_t w) {
@@ -47,6 +69,42 @@ inline uint64_t diag_flip(uint64_t x){
 	return x;
 }
 
+// Get the index of the least significant bit (w must not be 0)
+inline unsigned int bitscan(uint64_t w) {
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, w);
+	return index;
+#elif defined(__GNUC__)
+	return __builtin_ctzll(w);
+#else
+	static const unsigned int debruijn_index[64] = {
+		0, 1,48, 2,57,49,28, 3,61,58,50,42,38,29,17, 4,
+		62,55,59,36,53,51,43,22,45,39,33,30,24,18,12, 5,
+		63,47,56,27,60,41,37,16,54,35,52,21,44,32,23,11,
+		46,26,40,15,34,20,31,10,25,14,19, 9,13, 8, 7, 6 };
+	return debruijn_index[((w & (0 - w)) * 0x03f79d71b4cb0a89ULL) >> 58];
+#endif
+}
+
+// Get the index of the least significant bit and remove it from w
+inline unsigned int pop_lsb(uint64_t & w) {
+	unsigned int index = bitscan(w);
+	w &= w - 1;
+	return index;
+}
+
+#if PEXT_AVAILABLE
+// Gather the bits of w selected by mask into the low bits of the output.
+// Only call this if the processor supports BMI2.
+#if defined(__GNUC__) && !defined(__BMI2__)
+__attribute__((target("bmi2")))
+#endif
+inline uint64_t pext(uint64_t w, uint64_t mask) {
+	return _pext_u64(w, mask);
+}
+#endif
+
 inline unsigned int maxbit(uint32_t n) {
 	n |= (n >> 1);
 	n |= (n >> 2);